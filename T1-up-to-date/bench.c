@@ -0,0 +1,206 @@
+#include "lib.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Total number of elements appended per policy and final array size */
+#define BENCH_ELEMENTS 20000000
+
+/* Number of elements sorted per input pattern */
+#define BENCH_SORT_ELEMENTS 2000000
+
+typedef struct {
+    const char          *name;
+    enum cc_array_growth growth;
+} policy_t;
+
+static const policy_t POLICIES[] = {
+    { "factor",     CC_ARRAY_GROWTH_FACTOR     },
+    { "double",     CC_ARRAY_GROWTH_DOUBLE     },
+    { "half",       CC_ARRAY_GROWTH_HALF       },
+    { "additive",   CC_ARRAY_GROWTH_ADDITIVE   },
+    { "size-class", CC_ARRAY_GROWTH_SIZE_CLASS },
+};
+
+static const size_t SIZES[] = { 8, 100, 10000, 1000000 };
+
+static double now_ns() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * Fills arrays of the given final size until BENCH_ELEMENTS elements have
+ * been appended and reports the time per append, the number of buffer
+ * resizes and the unused capacity of a single array.
+ */
+static bool bench_policy(policy_t const *policy, size_t n) {
+    CC_ArrayConf conf;
+    cc_array_conf_init(&conf);
+    conf.capacity = 1;
+    conf.growth   = policy->growth;
+
+    size_t rounds  = BENCH_ELEMENTS / n;
+    size_t resizes = 0;
+    size_t capacity = 0;
+
+    double start = now_ns();
+
+    for (size_t r = 0; r < rounds; r++) {
+        CC_Array *ar;
+        if (cc_array_new_conf(&conf, &ar) != CC_OK)
+            return false;
+
+        size_t cap = cc_array_capacity(ar);
+
+        for (size_t i = 0; i < n; i++) {
+            if (cc_array_add(ar, (void*) (i + 1)) != CC_OK) {
+                cc_array_destroy(ar);
+                return false;
+            }
+            /* Only the first round is inspected to keep the timing honest */
+            if (r == 0 && cc_array_capacity(ar) != cap) {
+                cap = cc_array_capacity(ar);
+                resizes++;
+            }
+        }
+        if (r == 0)
+            capacity = cc_array_capacity(ar);
+
+        cc_array_destroy(ar);
+    }
+
+    double elapsed = now_ns() - start;
+
+    printf("%-10s %10zu %10.2f %8zu %9.1f%%\n",
+           policy->name,
+           n,
+           elapsed / (double) (rounds * n),
+           resizes,
+           100.0 * (capacity - n) / (double) capacity);
+
+    return true;
+}
+
+static int bench_cmp(const void *a, const void *b) {
+    size_t x = *(size_t const*) *(void* const*) a;
+    size_t y = *(size_t const*) *(void* const*) b;
+    return (x > y) - (x < y);
+}
+
+static uint64_t bench_key(const void *e) {
+    return *(size_t const*) e;
+}
+
+static const char *PATTERNS[] = { "random", "sorted", "reversed", "few-values", "two-runs" };
+
+static size_t pattern_value(size_t pattern, size_t i, size_t *seed) {
+    switch (pattern) {
+    case 1:  return i;
+    case 2:  return BENCH_SORT_ELEMENTS - i;
+    case 3:  return i % 16;
+    case 4:  return i < BENCH_SORT_ELEMENTS / 2 ? 2 * i : 2 * i - BENCH_SORT_ELEMENTS + 1;
+    default:
+        *seed = *seed * 6364136223846793005u + 1442695040888963407u;
+        return *seed >> 16;
+    }
+}
+
+/*
+ * Sorts the same pointers to the same values with qsort(), cc_array_sort(),
+ * cc_array_sort_stable(), cc_array_sort_parallel() and
+ * cc_array_sort_by_key() and reports the time per element of each.
+ */
+static bool bench_sort(size_t pattern) {
+    size_t *values = malloc(BENCH_SORT_ELEMENTS * sizeof(size_t));
+    void  **ptrs   = malloc(BENCH_SORT_ELEMENTS * sizeof(void*));
+    CC_Array *ar   = NULL;
+    CC_Array *copy = NULL;
+    CC_Array *par  = NULL;
+    CC_Array *keys = NULL;
+    bool ok        = values && ptrs && cc_array_new(&ar) == CC_OK;
+
+    size_t seed = 42;
+    for (size_t i = 0; ok && i < BENCH_SORT_ELEMENTS; i++) {
+        values[i] = pattern_value(pattern, i, &seed);
+        ptrs[i]   = &values[i];
+        ok = cc_array_add(ar, &values[i]) == CC_OK;
+    }
+
+    if (ok)
+        ok = cc_array_copy_shallow(ar, &copy) == CC_OK &&
+             cc_array_copy_shallow(ar, &par) == CC_OK &&
+             cc_array_copy_shallow(ar, &keys) == CC_OK;
+
+    if (ok) {
+        double start = now_ns();
+        qsort(ptrs, BENCH_SORT_ELEMENTS, sizeof(void*), bench_cmp);
+        double qsort_ns = now_ns() - start;
+
+        start = now_ns();
+        cc_array_sort(ar, bench_cmp);
+        double sort_ns = now_ns() - start;
+
+        start = now_ns();
+        ok = cc_array_sort_stable(copy, bench_cmp) == CC_OK;
+        double stable_ns = now_ns() - start;
+
+        start = now_ns();
+        ok = ok && cc_array_sort_parallel(par, bench_cmp, 0) == CC_OK;
+        double par_ns = now_ns() - start;
+
+        start = now_ns();
+        ok = ok && cc_array_sort_by_key(keys, bench_key) == CC_OK;
+        double key_ns = now_ns() - start;
+
+        printf("%-10s %10d %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+               PATTERNS[pattern],
+               BENCH_SORT_ELEMENTS,
+               qsort_ns / BENCH_SORT_ELEMENTS,
+               sort_ns / BENCH_SORT_ELEMENTS,
+               stable_ns / BENCH_SORT_ELEMENTS,
+               par_ns / BENCH_SORT_ELEMENTS,
+               key_ns / BENCH_SORT_ELEMENTS);
+    }
+
+    if (keys)
+        cc_array_destroy(keys);
+    if (par)
+        cc_array_destroy(par);
+    if (copy)
+        cc_array_destroy(copy);
+    if (ar)
+        cc_array_destroy(ar);
+    free(ptrs);
+    free(values);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    (void) argc;
+    (void) argv;
+
+    printf("%-10s %10s %10s %8s %10s\n", "policy", "size", "ns/add", "resizes", "unused");
+
+    for (size_t s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); s++) {
+        for (size_t p = 0; p < sizeof(POLICIES) / sizeof(POLICIES[0]); p++) {
+            if (!bench_policy(&POLICIES[p], SIZES[s])) {
+                fprintf(stderr, "Benchmark of %s failed\n", POLICIES[p].name);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    printf("\n%-10s %10s %10s %10s %10s %10s %10s\n",
+           "pattern", "size", "qsort ns", "sort ns", "stable ns", "par ns", "key ns");
+
+    for (size_t p = 0; p < sizeof(PATTERNS) / sizeof(PATTERNS[0]); p++) {
+        if (!bench_sort(p)) {
+            fprintf(stderr, "Benchmark of %s sort failed\n", PATTERNS[p]);
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -18,11 +18,96 @@
  * along with Collections-C.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* mremap */
+#endif
+
 #include "lib.h"
 
+#include <limits.h>
+#include <stddef.h>
+
+#if defined(__linux__)
+#define CC_ARRAY_MMAP
+#include <sys/mman.h>
+#include <unistd.h>
+#endif /* __linux__ */
+
+#if defined(__GLIBC__)
+#define CC_ARRAY_USABLE_SIZE
+#include <malloc.h>
+#endif /* __GLIBC__ */
+
+#if !defined(CC_ARRAY_NO_THREADS) && (defined(__unix__) || defined(__APPLE__))
+#define CC_ARRAY_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif /* CC_ARRAY_NO_THREADS */
+
 #define DEFAULT_CAPACITY 8
 #define DEFAULT_EXPANSION_FACTOR 2
 
+/* CC_ARRAY_GROWTH_ADDITIVE adds this many slots until the capacity
+ * reaches the limit */
+#define GROWTH_ADDITIVE_STEP  16
+#define GROWTH_ADDITIVE_LIMIT 256
+
+/* Granularity of small allocator size classes and of pages for
+ * CC_ARRAY_GROWTH_SIZE_CLASS */
+#define GROWTH_SIZE_CLASS_ALIGN 16
+#define GROWTH_SIZE_CLASS_PAGE  4096
+
+/* Smallest number of slots in the table of an index */
+#define INDEX_MIN_CAPACITY 16
+
+/* Partitions shorter than this are finished with an insertion sort */
+#define SORT_INSERTION_THRESHOLD 24
+
+/* Partitions longer than this use Tukey's ninther as the pivot */
+#define SORT_NINTHER_THRESHOLD 128
+
+/* Number of elements a partial insertion sort may move before giving up */
+#define SORT_PARTIAL_INSERTION_LIMIT 8
+
+/* Arrays shorter than this are sorted stably with a binary insertion sort */
+#define SORT_MIN_MERGE 32
+
+/* Consecutive wins of one run after which a merge starts galloping */
+#define SORT_MIN_GALLOP 7
+
+/* Maximum number of pending runs of a stable sort, enough for any size */
+#define SORT_MAX_RUNS 85
+
+/* Smallest number of elements a parallel sort hands to each thread */
+#define SORT_PARALLEL_MIN_CHUNK 32768
+
+/* Maximum number of threads used by a parallel sort */
+#define SORT_PARALLEL_MAX_THREADS 256
+
+/* A radix sort by key makes one pass over each byte of the 64-bit keys */
+#define SORT_RADIX_PASSES  8
+#define SORT_RADIX_BUCKETS 256
+
+typedef int (*sort_cmp_fn) (const void*, const void*);
+
+/* Entry of an index. A count of zero marks an empty slot, since any
+ * pointer, including NULL, may be stored in the array. */
+typedef struct array_index_entry_s {
+    void   *key;
+    size_t  first;
+    size_t  count;
+} ArrayIndexEntry;
+
+/* Open addressing hash index from elements to their positions */
+typedef struct array_index_s {
+    ArrayIndexEntry *table;
+    size_t           capacity;
+    size_t           entries;
+
+    /* Set when the positions in the table no longer match the array */
+    bool             dirty;
+} ArrayIndex;
+
 struct cc_array_s {
     size_t   size;
     size_t   capacity;
@@ -32,9 +117,122 @@ struct cc_array_s {
     void *(*mem_alloc)  (size_t size);
     void *(*mem_calloc) (size_t blocks, size_t size);
     void  (*mem_free)   (void *block);
+    void *(*mem_realloc) (void *block, size_t size);
+
+    CC_Allocator const *allocator;
+
+    /* Buffers of at least this many bytes are mapped, and when the
+     * current buffer is mapped, the length of the mapping. */
+    size_t   mmap_threshold;
+    size_t   mapped;
+
+    /* Slots stored inline at the end of the structure that back the
+     * buffer for as long as the capacity fits in them. */
+    size_t   inline_capacity;
+    bool     fixed;
+
+    /* Shrink policy and the capacity below which it never shrinks */
+    bool     auto_shrink;
+    size_t   min_capacity;
+
+    enum cc_array_growth growth;
+
+    /* Reference count of a buffer shared with copy-on-write copies,
+     * or NULL if the buffer is not shared */
+    size_t  *refs;
+
+    /* Optional hash index of the elements, or NULL */
+    ArrayIndex *index;
+
+    /* Comparator by which the elements are known to be sorted, or NULL */
+    int (*sorted_cmp) (const void*, const void*);
+
+    void    *inline_buf[];
 };
 
 static enum cc_stat expand_capacity(CC_Array *ar);
+static enum cc_stat ensure_capacity(CC_Array *ar, size_t n);
+static size_t       grow_capacity(CC_Array const *ar);
+static void         claim_slack(CC_Array *ar);
+static enum cc_stat resize_buffer(CC_Array *ar, size_t new_capacity);
+static void         shrink_capacity(CC_Array *ar);
+static void       **buffer_alloc(CC_Array *ar, size_t capacity);
+static void         buffer_free(CC_Array *ar);
+static enum cc_stat buffer_unshare(CC_Array *ar, size_t capacity);
+
+#ifdef CC_ARRAY_MMAP
+static size_t       page_round(size_t bytes);
+#endif
+static void         array_inherit_conf(CC_Array const *ar, CC_Array *copy);
+
+static ArrayIndexEntry *index_find(ArrayIndex const *ix, void const *key);
+static bool         index_ready(CC_Array *ar);
+static void         index_add(CC_Array *ar, void *key, size_t pos);
+static INLINE void  index_appended(CC_Array *ar);
+static void         index_appended_from(CC_Array *ar, size_t from);
+static void         index_removed(CC_Array *ar, void *key, size_t pos);
+static void         index_moved(CC_Array *ar, void *key, size_t from, size_t to);
+static void         index_opened(CC_Array *ar, size_t pos, size_t n);
+static void         index_closed(CC_Array *ar, size_t pos, size_t n);
+static INLINE void  index_invalidate(CC_Array *ar);
+static void         index_clear(CC_Array *ar);
+
+/**
+ * Returns the size of a CC_Array structure holding the specified number of
+ * inline slots.
+ */
+static INLINE size_t array_struct_size(size_t inline_capacity)
+{
+    return sizeof(CC_Array) + inline_capacity * sizeof(void*);
+}
+
+/**
+ * Returns true if the buffer of the CC_Array lives in its inline slots.
+ */
+static INLINE bool array_is_inline(CC_Array const *ar)
+{
+    return ar->buffer == ar->inline_buf;
+}
+
+/**
+ * Makes sure that the CC_Array owns its buffer before it is modified by
+ * copying a buffer that is shared with copy-on-write copies.
+ *
+ * @return CC_OK if the array owns its buffer, or CC_ERR_ALLOC if the memory
+ * allocation for the copy failed.
+ */
+static INLINE enum cc_stat array_own_buffer(CC_Array *ar)
+{
+    if (!ar->refs)
+        return CC_OK;
+    return buffer_unshare(ar, ar->capacity);
+}
+
+/**
+ * Allocation helpers that route through the context allocator when the
+ * array was configured with one and through the plain allocators otherwise.
+ */
+static INLINE void *array_alloc(CC_Array const *ar, size_t size)
+{
+    if (ar->allocator)
+        return ar->allocator->mem_alloc(ar->allocator->ctx, size);
+    return ar->mem_alloc(size);
+}
+
+static INLINE void *array_calloc(CC_Array const *ar, size_t blocks, size_t size)
+{
+    if (ar->allocator)
+        return ar->allocator->mem_calloc(ar->allocator->ctx, blocks, size);
+    return ar->mem_calloc(blocks, size);
+}
+
+static INLINE void array_free(CC_Array const *ar, void *block)
+{
+    if (ar->allocator)
+        ar->allocator->mem_free(ar->allocator->ctx, block);
+    else
+        ar->mem_free(block);
+}
 
 
 /**
@@ -84,24 +282,106 @@ enum cc_stat cc_array_new_conf(CC_ArrayConf const * const conf, CC_Array **out)
     if (!conf->capacity || ex >= CC_MAX_ELEMENTS / conf->capacity)
         return CC_ERR_INVALID_CAPACITY;
 
-    CC_Array *ar = conf->mem_calloc(1, sizeof(CC_Array));
+    if (conf->inline_capacity > (CC_MAX_ELEMENTS - sizeof(CC_Array)) / sizeof(void*))
+        return CC_ERR_INVALID_CAPACITY;
+
+    size_t capacity = conf->capacity;
+
+    /* Start out in the inline slots whenever the requested capacity fits */
+    if (capacity < conf->inline_capacity)
+        capacity = conf->inline_capacity;
+
+    CC_Allocator const *a = conf->allocator;
+    size_t struct_size    = array_struct_size(conf->inline_capacity);
+    CC_Array *ar;
+
+    if (a)
+        ar = a->mem_calloc(a->ctx, 1, struct_size);
+    else
+        ar = conf->mem_calloc(1, struct_size);
 
     if (!ar)
         return CC_ERR_ALLOC;
 
-    void **buff = conf->mem_alloc(conf->capacity * sizeof(void*));
+    ar->allocator       = a;
+    ar->mem_alloc       = conf->mem_alloc;
+    ar->mem_calloc      = conf->mem_calloc;
+    ar->mem_free        = conf->mem_free;
+    ar->mem_realloc     = conf->mem_realloc;
+    /* realloc is only safe on buffers that came from malloc */
+    if (!ar->mem_realloc && conf->mem_alloc == malloc && conf->mem_free == free)
+        ar->mem_realloc = realloc;
+    /* Mappings would escape a context allocator such as an arena, which
+     * releases its memory without destroying the arrays */
+    ar->mmap_threshold  = a ? 0 : conf->mmap_threshold;
+    ar->inline_capacity = conf->inline_capacity;
+    ar->auto_shrink     = conf->auto_shrink;
+    ar->min_capacity    = capacity;
+    ar->growth          = conf->growth;
+
+    void **buff = buffer_alloc(ar, capacity);
 
     if (!buff) {
-        conf->mem_free(ar);
+        array_free(ar, ar);
         return CC_ERR_ALLOC;
     }
 
     ar->buffer     = buff;
     ar->exp_factor = ex;
-    ar->capacity   = conf->capacity;
-    ar->mem_alloc  = conf->mem_alloc;
-    ar->mem_calloc = conf->mem_calloc;
-    ar->mem_free   = conf->mem_free;
+    ar->capacity   = capacity;
+
+    *out = ar;
+    return CC_OK;
+}
+
+/**
+ * Creates a new empty CC_Array that can hold at most capacity elements and
+ * returns a status code. The array structure and its buffer are placed in a
+ * single allocation, and the array never grows past its initial capacity.
+ *
+ * @param[in] capacity the maximum number of elements the array can hold
+ * @param[out] out pointer to where the newly created CC_Array is to be stored
+ *
+ * @return CC_OK if the creation was successful, CC_ERR_INVALID_CAPACITY if
+ * the capacity is zero or too large, or CC_ERR_ALLOC if the memory
+ * allocation for the new CC_Array structure failed.
+ */
+enum cc_stat cc_array_new_fixed(size_t capacity, CC_Array **out)
+{
+    CC_ArrayConf c;
+    cc_array_conf_init(&c);
+    c.capacity = capacity;
+    return cc_array_new_fixed_conf(&c, out);
+}
+
+/**
+ * Creates a new empty fixed capacity CC_Array based on the specified
+ * CC_ArrayConf struct and returns a status code. The capacity of the
+ * configuration becomes the maximum capacity of the array, while its
+ * inline_capacity and exp_factor are ignored. Adding elements to a full
+ * fixed capacity array fails with CC_ERR_MAX_CAPACITY.
+ *
+ * @param[in] conf array configuration structure
+ * @param[out] out pointer to where the newly created CC_Array is to be stored
+ *
+ * @return CC_OK if the creation was successful, CC_ERR_INVALID_CAPACITY if
+ * the capacity is zero or too large, or CC_ERR_ALLOC if the memory
+ * allocation for the new CC_Array structure failed.
+ */
+enum cc_stat cc_array_new_fixed_conf(CC_ArrayConf const * const conf, CC_Array **out)
+{
+    CC_ArrayConf c = *conf;
+
+    c.exp_factor      = DEFAULT_EXPANSION_FACTOR;
+    c.inline_capacity = c.capacity;
+
+    CC_Array *ar;
+    enum cc_stat status = cc_array_new_conf(&c, &ar);
+
+    if (status != CC_OK)
+        return status;
+
+    ar->fixed = true;
 
     *out = ar;
     return CC_OK;
@@ -114,11 +394,17 @@ enum cc_stat cc_array_new_conf(CC_ArrayConf const * const conf, CC_Array **out)
  */
 void cc_array_conf_init(CC_ArrayConf *conf)
 {
-    conf->exp_factor = DEFAULT_EXPANSION_FACTOR;
-    conf->capacity   = DEFAULT_CAPACITY;
-    conf->mem_alloc  = malloc;
-    conf->mem_calloc = calloc;
-    conf->mem_free   = free;
+    conf->exp_factor      = DEFAULT_EXPANSION_FACTOR;
+    conf->capacity        = DEFAULT_CAPACITY;
+    conf->mem_alloc       = malloc;
+    conf->mem_calloc      = calloc;
+    conf->mem_free        = free;
+    conf->mem_realloc     = NULL;
+    conf->mmap_threshold  = 0;
+    conf->allocator       = NULL;
+    conf->inline_capacity = 0;
+    conf->auto_shrink     = false;
+    conf->growth          = CC_ARRAY_GROWTH_FACTOR;
 }
 
 /**
@@ -128,8 +414,9 @@ void cc_array_conf_init(CC_ArrayConf *conf)
  */
 void cc_array_destroy(CC_Array *ar)
 {
-    ar->mem_free(ar->buffer);
-    ar->mem_free(ar);
+    cc_array_index_disable(ar);
+    buffer_free(ar);
+    array_free(ar, ar);
 }
 
 /**
@@ -168,9 +455,13 @@ enum cc_stat cc_array_add(CC_Array *ar, void *element)
         if (status != CC_OK)
             return status;
     }
+    if (array_own_buffer(ar) != CC_OK)
+        return CC_ERR_ALLOC;
 
     ar->buffer[ar->size] = element;
     ar->size++;
+    index_appended(ar);
+    ar->sorted_cmp = NULL;
 
     return CC_OK;
 }
@@ -204,6 +495,8 @@ enum cc_stat cc_array_add_at(CC_Array *ar, void *element, size_t index)
         if (status != CC_OK)
             return status;
     }
+    if (array_own_buffer(ar) != CC_OK)
+        return CC_ERR_ALLOC;
 
     size_t shift = (ar->size - index) * sizeof(void*);
 
@@ -213,6 +506,123 @@ enum cc_stat cc_array_add_at(CC_Array *ar, void *element, size_t index)
 
     ar->buffer[index] = element;
     ar->size++;
+    index_opened(ar, index, 1);
+    if (ar->index && !ar->index->dirty)
+        index_add(ar, element, index);
+    ar->sorted_cmp = NULL;
+
+    return CC_OK;
+}
+
+/**
+ * Appends n elements from the src buffer to the end of the CC_Array, in
+ * order. The array grows at most once, after which the elements are copied
+ * over in bulk.
+ *
+ * @note The src buffer must not point into the buffer of the array itself,
+ *       since growing the array may move or free that buffer. Use
+ *       <code>cc_array_append_array()</code> to append an array to itself.
+ *
+ * @param[in] ar the array to which the elements are being added
+ * @param[in] src buffer holding the elements that are being added
+ * @param[in] n number of elements in the src buffer
+ *
+ * @return CC_OK if the elements were successfully added, CC_ERR_ALLOC if the
+ * memory allocation for the new elements failed, or CC_ERR_MAX_CAPACITY if
+ * the array cannot hold all the new elements. Nothing is added on failure.
+ */
+enum cc_stat cc_array_add_all(CC_Array *ar, void * const *src, size_t n)
+{
+    if (n == 0)
+        return CC_OK;
+
+    enum cc_stat status = ensure_capacity(ar, n);
+    if (status != CC_OK)
+        return status;
+
+    memcpy(&(ar->buffer[ar->size]), src, n * sizeof(void*));
+    ar->size += n;
+    index_appended_from(ar, ar->size - n);
+    ar->sorted_cmp = NULL;
+
+    return CC_OK;
+}
+
+/**
+ * Inserts n elements from the src buffer into the CC_Array at the specified
+ * position, in order, by shifting all subsequent elements by n. The index
+ * must be within the bounds of the array or equal to its size. The array
+ * grows at most once and the tail is shifted only once.
+ *
+ * @note The src buffer must not point into the buffer of the array itself.
+ *
+ * @param[in] ar the array to which the elements are being added
+ * @param[in] src buffer holding the elements that are being added
+ * @param[in] n number of elements in the src buffer
+ * @param[in] index the position in the array at which the first element is
+ *            being added
+ *
+ * @return CC_OK if the elements were successfully added, CC_ERR_OUT_OF_RANGE
+ * if the specified index was not in range, CC_ERR_ALLOC if the memory
+ * allocation for the new elements failed, or CC_ERR_MAX_CAPACITY if the
+ * array cannot hold all the new elements. Nothing is added on failure.
+ */
+enum cc_stat cc_array_add_range_at(CC_Array *ar, void * const *src, size_t n, size_t index)
+{
+    if (index > ar->size)
+        return CC_ERR_OUT_OF_RANGE;
+
+    if (n == 0)
+        return CC_OK;
+
+    enum cc_stat status = ensure_capacity(ar, n);
+    if (status != CC_OK)
+        return status;
+
+    memmove(&(ar->buffer[index + n]),
+            &(ar->buffer[index]),
+            (ar->size - index) * sizeof(void*));
+
+    memcpy(&(ar->buffer[index]), src, n * sizeof(void*));
+    ar->size += n;
+
+    index_opened(ar, index, n);
+    for (size_t i = index; i < index + n && ar->index && !ar->index->dirty; i++)
+        index_add(ar, ar->buffer[i], i);
+    ar->sorted_cmp = NULL;
+
+    return CC_OK;
+}
+
+/**
+ * Appends all elements of the src CC_Array to the end of the dst CC_Array, in
+ * order. The destination grows at most once, after which the elements are
+ * copied over in bulk. Both arguments may refer to the same array.
+ *
+ * @param[in] dst the array to which the elements are being added
+ * @param[in] src the array whose elements are being added
+ *
+ * @return CC_OK if the elements were successfully added, CC_ERR_ALLOC if the
+ * memory allocation for the new elements failed, or CC_ERR_MAX_CAPACITY if
+ * the destination array cannot hold all the new elements. Nothing is added
+ * on failure.
+ */
+enum cc_stat cc_array_append_array(CC_Array *dst, CC_Array *src)
+{
+    size_t n = src->size;
+
+    if (n == 0)
+        return CC_OK;
+
+    enum cc_stat status = ensure_capacity(dst, n);
+    if (status != CC_OK)
+        return status;
+
+    /* src->buffer is read only after the growth in case src is dst */
+    memcpy(&(dst->buffer[dst->size]), src->buffer, n * sizeof(void*));
+    dst->size += n;
+    index_appended_from(dst, dst->size - n);
+    dst->sorted_cmp = NULL;
 
     return CC_OK;
 }
@@ -236,10 +646,19 @@ enum cc_stat cc_array_replace_at(CC_Array *ar, void *element, size_t index, void
     if (index >= ar->size)
         return CC_ERR_OUT_OF_RANGE;
 
+    if (array_own_buffer(ar) != CC_OK)
+        return CC_ERR_ALLOC;
+
     if (out)
         *out = ar->buffer[index];
 
-    ar->buffer[index] = element;
+    if (ar->buffer[index] != element) {
+        index_removed(ar, ar->buffer[index], index);
+        ar->buffer[index] = element;
+        if (ar->index && !ar->index->dirty)
+            index_add(ar, element, index);
+        ar->sorted_cmp = NULL;
+    }
 
     return CC_OK;
 }
@@ -251,10 +670,19 @@ enum cc_stat cc_array_swap_at(CC_Array *ar, size_t index1, size_t index2)
     if (index1 >= ar->size || index2 >= ar->size)
         return CC_ERR_OUT_OF_RANGE;
 
+    if (array_own_buffer(ar) != CC_OK)
+        return CC_ERR_ALLOC;
+
     tmp = ar->buffer[index1];
 
+    if (tmp == ar->buffer[index2])
+        return CC_OK;
+
     ar->buffer[index1] = ar->buffer[index2];
     ar->buffer[index2] = tmp;
+    index_moved(ar, tmp, index1, index2);
+    index_moved(ar, ar->buffer[index1], index2, index1);
+    ar->sorted_cmp = NULL;
     return CC_OK;
 }
 
@@ -278,14 +706,21 @@ enum cc_stat cc_array_remove(CC_Array *ar, void *element, void **out)
     if (status == CC_ERR_OUT_OF_RANGE)
         return CC_ERR_VALUE_NOT_FOUND;
 
+    if (array_own_buffer(ar) != CC_OK)
+        return CC_ERR_ALLOC;
+
+    index_removed(ar, element, index);
+
     if (index != ar->size - 1) {
         size_t block_size = (ar->size - 1 - index) * sizeof(void*);
 
         memmove(&(ar->buffer[index]),
                 &(ar->buffer[index + 1]),
                 block_size);
+        index_closed(ar, index, 1);
     }
     ar->size--;
+    shrink_capacity(ar);
 
     if (out)
         *out = element;
@@ -311,17 +746,24 @@ enum cc_stat cc_array_remove_at(CC_Array *ar, size_t index, void **out)
     if (index >= ar->size)
         return CC_ERR_OUT_OF_RANGE;
 
+    if (array_own_buffer(ar) != CC_OK)
+        return CC_ERR_ALLOC;
+
     if (out)
         *out = ar->buffer[index];
 
+    index_removed(ar, ar->buffer[index], index);
+
     if (index != ar->size - 1) {
         size_t block_size = (ar->size - 1 - index) * sizeof(void*);
 
         memmove(&(ar->buffer[index]),
                 &(ar->buffer[index + 1]),
                 block_size);
+        index_closed(ar, index, 1);
     }
     ar->size--;
+    shrink_capacity(ar);
 
     return CC_OK;
 }
@@ -343,77 +785,303 @@ enum cc_stat cc_array_remove_last(CC_Array *ar, void **out)
 }
 
 /**
- * Removes all elements from the specified array. This function does not shrink
- * the array capacity.
+ * Removes the first occurrence of the element from the CC_Array without
+ * preserving the order of the remaining elements. The last element takes the
+ * place of the removed one, so no elements are shifted.
  *
- * @param[in] ar array from which all elements are to be removed
+ * @param[in] ar the array from which the element is being removed
+ * @param[in] element the element being removed
+ * @param[out] out pointer to where the removed value is stored,
+ *                 or NULL if it is to be ignored
+ *
+ * @return CC_OK if the element was successfully removed, or
+ * CC_ERR_VALUE_NOT_FOUND if the element was not found.
  */
-void cc_array_remove_all(CC_Array *ar)
+enum cc_stat cc_array_remove_unordered(CC_Array *ar, void *element, void **out)
 {
-    ar->size = 0;
+    size_t index;
+
+    if (cc_array_index_of(ar, element, &index) != CC_OK)
+        return CC_ERR_VALUE_NOT_FOUND;
+
+    return cc_array_remove_at_unordered(ar, index, out);
 }
 
 /**
- * Removes and frees all elements from the specified array. This function does
- * not shrink the array capacity.
+ * Removes the CC_Array element at the specified index without preserving the
+ * order of the remaining elements and optionally sets the out parameter to
+ * the value of the removed element. The last element takes the place of the
+ * removed one, so the removal takes constant time.
  *
- * @param[in] ar array from which all elements are to be removed
+ * @param[in] ar the array from which the element is being removed
+ * @param[in] index the index of the element being removed.
+ * @param[out] out  pointer to where the removed value is stored,
+ *                  or NULL if it is to be ignored
+ *
+ * @return CC_OK if the element was successfully removed, or CC_ERR_OUT_OF_RANGE
+ * if the index was out of range.
  */
-void cc_array_remove_all_free(CC_Array *ar)
+enum cc_stat cc_array_remove_at_unordered(CC_Array *ar, size_t index, void **out)
 {
-    size_t i;
-    for (i = 0; i < ar->size; i++)
-        free(ar->buffer[i]);
+    if (index >= ar->size)
+        return CC_ERR_OUT_OF_RANGE;
 
-    cc_array_remove_all(ar);
+    if (array_own_buffer(ar) != CC_OK)
+        return CC_ERR_ALLOC;
+
+    if (out)
+        *out = ar->buffer[index];
+
+    index_removed(ar, ar->buffer[index], index);
+
+    ar->size--;
+    ar->buffer[index] = ar->buffer[ar->size];
+
+    if (index < ar->size) {
+        index_moved(ar, ar->buffer[index], ar->size, index);
+        ar->sorted_cmp = NULL;
+    }
+    shrink_capacity(ar);
+
+    return CC_OK;
 }
 
 /**
- * Gets an CC_Array element from the specified index and sets the out parameter to
- * its value. The specified index must be within the bounds of the array.
+ * Removes the elements in the specified index range from the CC_Array and
+ * optionally copies them into the out buffer. The gap is closed with a single
+ * shift of the subsequent elements.
  *
- * @param[in] ar the array from which the element is being retrieved
- * @param[in] index the index of the array element
- * @param[out] out pointer to where the element is stored
+ * @param[in] ar the array from which the elements are being removed
+ * @param[in] b the beginning index (inclusive) of the range that must be
+ *              within the bounds of the array and must not exceed the end
+ *              index
+ * @param[in] e the end index (inclusive) of the range that must be within the
+ *              bounds of the array and must be greater or equal to the
+ *              beginning index
+ * @param[out] out buffer of at least e - b + 1 slots to where the removed
+ *                 elements are copied, or NULL if they are to be ignored
  *
- * @return CC_OK if the element was found, or CC_ERR_OUT_OF_RANGE if the index
- * was out of range.
+ * @return CC_OK if the elements were successfully removed, or
+ * CC_ERR_INVALID_RANGE if the specified index range is invalid.
  */
-enum cc_stat cc_array_get_at(CC_Array *ar, size_t index, void **out)
+enum cc_stat cc_array_remove_range(CC_Array *ar, size_t b, size_t e, void **out)
 {
-    if (index >= ar->size)
-        return CC_ERR_OUT_OF_RANGE;
+    if (b > e || e >= ar->size)
+        return CC_ERR_INVALID_RANGE;
+
+    size_t n = e - b + 1;
+
+    if (array_own_buffer(ar) != CC_OK)
+        return CC_ERR_ALLOC;
+
+    if (out)
+        memcpy(out, &(ar->buffer[b]), n * sizeof(void*));
+
+    memmove(&(ar->buffer[b]),
+            &(ar->buffer[e + 1]),
+            (ar->size - e - 1) * sizeof(void*));
+
+    ar->size -= n;
+    index_invalidate(ar);
+    shrink_capacity(ar);
 
-    *out = ar->buffer[index];
     return CC_OK;
 }
 
 /**
- * Gets the last element of the array or the element at the highest index
- * and sets the out parameter to its value.
+ * Removes the elements at the specified indices from the CC_Array and
+ * compacts the remaining elements in a single pass. The indices must be
+ * sorted in a strictly ascending order and must be within the bounds of the
+ * array. The array is left untouched if they are not.
  *
- * @param[in] ar the array whose last element is being returned
- * @param[out] out pointer to where the element is stored
+ * @param[in] ar the array from which the elements are being removed
+ * @param[in] indices sorted indices of the elements that are being removed
+ * @param[in] n number of indices
+ * @param[in] cb function that is invoked on each removed element, or NULL
  *
- * @return CC_OK if the element was found, or CC_ERR_VALUE_NOT_FOUND if the
- * CC_Array is empty.
+ * @return CC_OK if the elements were successfully removed, CC_ERR_OUT_OF_RANGE
+ * if an index is out of range, or CC_ERR_INVALID_RANGE if the indices are not
+ * strictly ascending.
  */
-enum cc_stat cc_array_get_last(CC_Array *ar, void **out)
+enum cc_stat cc_array_remove_indices(CC_Array *ar, const size_t *indices, size_t n, void (*cb) (void*))
 {
-    if (ar->size == 0)
-        return CC_ERR_VALUE_NOT_FOUND;
+    if (n == 0)
+        return CC_OK;
 
-    return cc_array_get_at(ar, ar->size - 1, out);
+    size_t i;
+    for (i = 0; i < n; i++) {
+        if (indices[i] >= ar->size)
+            return CC_ERR_OUT_OF_RANGE;
+        if (i > 0 && indices[i] <= indices[i - 1])
+            return CC_ERR_INVALID_RANGE;
+    }
+
+    if (array_own_buffer(ar) != CC_OK)
+        return CC_ERR_ALLOC;
+
+    size_t write = indices[0];
+
+    /* Move each run of kept elements between two removed ones in one go */
+    for (i = 0; i < n; i++) {
+        size_t read = indices[i] + 1;
+        size_t end  = i + 1 < n ? indices[i + 1] : ar->size;
+
+        if (cb)
+            cb(ar->buffer[indices[i]]);
+
+        if (end > read) {
+            memmove(&(ar->buffer[write]),
+                    &(ar->buffer[read]),
+                    (end - read) * sizeof(void*));
+            write += end - read;
+        }
+    }
+    ar->size = write;
+    index_invalidate(ar);
+    shrink_capacity(ar);
+
+    return CC_OK;
 }
 
 /**
- * Returns the underlying array buffer.
+ * Removes the elements at the specified indices from the CC_Array and
+ * compacts the remaining elements in a single pass. The indices may be given
+ * in any order and may repeat, in which case the element is removed once. The
+ * indices are first collected into a temporary bitmap that is allocated with
+ * the array's allocators. The array is left untouched on failure.
  *
- * @note Any direct modification of the buffer may invalidate the CC_Array.
- *
- * @param[in] ar array whose underlying buffer is being returned
+ * @param[in] ar the array from which the elements are being removed
+ * @param[in] indices indices of the elements that are being removed
+ * @param[in] n number of indices
+ * @param[in] cb function that is invoked on each removed element, or NULL
  *
- * @return array's internal buffer.
+ * @return CC_OK if the elements were successfully removed, CC_ERR_OUT_OF_RANGE
+ * if an index is out of range, or CC_ERR_ALLOC if the memory allocation for
+ * the bitmap failed.
+ */
+enum cc_stat cc_array_remove_indices_unsorted(CC_Array *ar, const size_t *indices, size_t n, void (*cb) (void*))
+{
+    if (n == 0)
+        return CC_OK;
+
+    const size_t bits = sizeof(size_t) * CHAR_BIT;
+
+    size_t i;
+    for (i = 0; i < n; i++) {
+        if (indices[i] >= ar->size)
+            return CC_ERR_OUT_OF_RANGE;
+    }
+
+    if (array_own_buffer(ar) != CC_OK)
+        return CC_ERR_ALLOC;
+
+    size_t *bitmap = array_calloc(ar, ar->size / bits + 1, sizeof(size_t));
+
+    if (!bitmap)
+        return CC_ERR_ALLOC;
+
+    for (i = 0; i < n; i++)
+        bitmap[indices[i] / bits] |= (size_t) 1 << (indices[i] % bits);
+
+    size_t write = 0;
+    for (i = 0; i < ar->size; i++) {
+        if (bitmap[i / bits] & ((size_t) 1 << (i % bits))) {
+            if (cb)
+                cb(ar->buffer[i]);
+            continue;
+        }
+        ar->buffer[write++] = ar->buffer[i];
+    }
+    array_free(ar, bitmap);
+
+    ar->size = write;
+    index_invalidate(ar);
+    shrink_capacity(ar);
+
+    return CC_OK;
+}
+
+/**
+ * Removes all elements from the specified array. This function does not shrink
+ * the array capacity unless the array was configured with auto_shrink.
+ *
+ * @param[in] ar array from which all elements are to be removed
+ */
+void cc_array_remove_all(CC_Array *ar)
+{
+    ar->size = 0;
+    index_clear(ar);
+    shrink_capacity(ar);
+
+#ifdef CC_ARRAY_MMAP
+    /* Keep the mapping, but let the kernel reclaim the pages */
+    if (ar->mapped && !ar->refs)
+        madvise(ar->buffer, ar->mapped, MADV_DONTNEED);
+#endif
+}
+
+/**
+ * Removes and frees all elements from the specified array. This function does
+ * not shrink the array capacity unless the array was configured with
+ * auto_shrink.
+ *
+ * @param[in] ar array from which all elements are to be removed
+ */
+void cc_array_remove_all_free(CC_Array *ar)
+{
+    size_t i;
+    for (i = 0; i < ar->size; i++)
+        free(ar->buffer[i]);
+
+    cc_array_remove_all(ar);
+}
+
+/**
+ * Gets an CC_Array element from the specified index and sets the out parameter to
+ * its value. The specified index must be within the bounds of the array.
+ *
+ * @param[in] ar the array from which the element is being retrieved
+ * @param[in] index the index of the array element
+ * @param[out] out pointer to where the element is stored
+ *
+ * @return CC_OK if the element was found, or CC_ERR_OUT_OF_RANGE if the index
+ * was out of range.
+ */
+enum cc_stat cc_array_get_at(CC_Array *ar, size_t index, void **out)
+{
+    if (index >= ar->size)
+        return CC_ERR_OUT_OF_RANGE;
+
+    *out = ar->buffer[index];
+    return CC_OK;
+}
+
+/**
+ * Gets the last element of the array or the element at the highest index
+ * and sets the out parameter to its value.
+ *
+ * @param[in] ar the array whose last element is being returned
+ * @param[out] out pointer to where the element is stored
+ *
+ * @return CC_OK if the element was found, or CC_ERR_VALUE_NOT_FOUND if the
+ * CC_Array is empty.
+ */
+enum cc_stat cc_array_get_last(CC_Array *ar, void **out)
+{
+    if (ar->size == 0)
+        return CC_ERR_VALUE_NOT_FOUND;
+
+    return cc_array_get_at(ar, ar->size - 1, out);
+}
+
+/**
+ * Returns the underlying array buffer.
+ *
+ * @note Any direct modification of the buffer may invalidate the CC_Array.
+ *
+ * @param[in] ar array whose underlying buffer is being returned
+ *
+ * @return array's internal buffer.
  */
 const void * const* cc_array_get_buffer(CC_Array *ar)
 {
@@ -433,6 +1101,16 @@ const void * const* cc_array_get_buffer(CC_Array *ar)
  */
 enum cc_stat cc_array_index_of(CC_Array *ar, void *element, size_t *index)
 {
+    if (index_ready(ar)) {
+        ArrayIndexEntry *e = index_find(ar->index, element);
+
+        if (!e)
+            return CC_ERR_OUT_OF_RANGE;
+
+        *index = e->first;
+        return CC_OK;
+    }
+
     size_t i;
     for (i = 0; i < ar->size; i++) {
         if (ar->buffer[i] == element) {
@@ -470,20 +1148,19 @@ enum cc_stat cc_array_subarray(CC_Array *ar, size_t b, size_t e, CC_Array **out)
     if (b > e || e >= ar->size)
         return CC_ERR_INVALID_RANGE;
 
-    CC_Array *sub_ar = ar->mem_calloc(1, sizeof(CC_Array));
+    CC_Array *sub_ar = array_calloc(ar, 1, array_struct_size(ar->inline_capacity));
 
     if (!sub_ar)
         return CC_ERR_ALLOC;
 
+    array_inherit_conf(ar, sub_ar);
+
     /* Try to allocate the buffer */
-    if (!(sub_ar->buffer = ar->mem_alloc(ar->capacity * sizeof(void*)))) {
-        ar->mem_free(sub_ar);
+    if (!(sub_ar->buffer = buffer_alloc(sub_ar, e - b + 1))) {
+        array_free(ar, sub_ar);
         return CC_ERR_ALLOC;
     }
 
-    sub_ar->mem_alloc  = ar->mem_alloc;
-    sub_ar->mem_calloc = ar->mem_calloc;
-    sub_ar->mem_free   = ar->mem_free;
     sub_ar->size       = e - b + 1;
     sub_ar->capacity   = sub_ar->size;
 
@@ -510,21 +1187,19 @@ enum cc_stat cc_array_subarray(CC_Array *ar, size_t b, size_t e, CC_Array **out)
  */
 enum cc_stat cc_array_copy_shallow(CC_Array *ar, CC_Array **out)
 {
-    CC_Array *copy = ar->mem_alloc(sizeof(CC_Array));
+    CC_Array *copy = array_calloc(ar, 1, array_struct_size(ar->inline_capacity));
 
     if (!copy)
         return CC_ERR_ALLOC;
 
-    if (!(copy->buffer = ar->mem_calloc(ar->capacity, sizeof(void*)))) {
-        ar->mem_free(copy);
+    array_inherit_conf(ar, copy);
+
+    if (!(copy->buffer = buffer_alloc(copy, ar->capacity))) {
+        array_free(ar, copy);
         return CC_ERR_ALLOC;
     }
-    copy->exp_factor = ar->exp_factor;
     copy->size       = ar->size;
     copy->capacity   = ar->capacity;
-    copy->mem_alloc  = ar->mem_alloc;
-    copy->mem_calloc = ar->mem_calloc;
-    copy->mem_free   = ar->mem_free;
 
     memcpy(copy->buffer,
            ar->buffer,
@@ -534,6 +1209,58 @@ enum cc_stat cc_array_copy_shallow(CC_Array *ar, CC_Array **out)
     return CC_OK;
 }
 
+/**
+ * Creates a copy-on-write shallow copy of the specified CC_Array. The copy
+ * shares the buffer of the original array until either of them is modified,
+ * at which point the modified array gets a buffer of its own. Creating the
+ * copy therefore does not copy any elements. Modifying an array whose buffer
+ * is shared may fail with CC_ERR_ALLOC if its own buffer cannot be allocated,
+ * in which case functions that do not return a status, such as
+ * <code>cc_array_sort()</code>, leave the array unchanged.
+ *
+ * @note The reference count of the shared buffer is not atomic, so arrays
+ *       sharing a buffer must not be used concurrently from several threads,
+ *       even if only one of them is modified. Arrays with inline buffers
+ *       cannot share them and are copied with
+ *       <code>cc_array_copy_shallow()</code> instead.
+ *
+ * @param[in] ar the array to be copied
+ * @param[out] out pointer to where the newly created copy is stored
+ *
+ * @return CC_OK if the copy was successfully created, or CC_ERR_ALLOC if the
+ * memory allocation for the copy failed.
+ */
+enum cc_stat cc_array_copy_cow(CC_Array *ar, CC_Array **out)
+{
+    if (array_is_inline(ar))
+        return cc_array_copy_shallow(ar, out);
+
+    CC_Array *copy = array_calloc(ar, 1, array_struct_size(ar->inline_capacity));
+
+    if (!copy)
+        return CC_ERR_ALLOC;
+
+    if (!ar->refs) {
+        if (!(ar->refs = array_alloc(ar, sizeof(size_t)))) {
+            array_free(ar, copy);
+            return CC_ERR_ALLOC;
+        }
+        *ar->refs = 1;
+    }
+    (*ar->refs)++;
+
+    array_inherit_conf(ar, copy);
+
+    copy->buffer   = ar->buffer;
+    copy->size     = ar->size;
+    copy->capacity = ar->capacity;
+    copy->mapped   = ar->mapped;
+    copy->refs     = ar->refs;
+
+    *out = copy;
+    return CC_OK;
+}
+
 /**
  * Creates a deep copy of the specified CC_Array. A deep copy is a copy of
  * both the CC_Array structure and the data it holds.
@@ -551,22 +1278,19 @@ enum cc_stat cc_array_copy_shallow(CC_Array *ar, CC_Array **out)
  */
 enum cc_stat cc_array_copy_deep(CC_Array *ar, void *(*cp) (void *), CC_Array **out)
 {
-    CC_Array *copy = ar->mem_alloc(sizeof(CC_Array));
+    CC_Array *copy = array_calloc(ar, 1, array_struct_size(ar->inline_capacity));
 
     if (!copy)
         return CC_ERR_ALLOC;
 
-    if (!(copy->buffer = ar->mem_calloc(ar->capacity, sizeof(void*)))) {
-        ar->mem_free(copy);
+    array_inherit_conf(ar, copy);
+
+    if (!(copy->buffer = buffer_alloc(copy, ar->capacity))) {
+        array_free(ar, copy);
         return CC_ERR_ALLOC;
     }
-
-    copy->exp_factor = ar->exp_factor;
     copy->size       = ar->size;
     copy->capacity   = ar->capacity;
-    copy->mem_alloc  = ar->mem_alloc;
-    copy->mem_calloc = ar->mem_calloc;
-    copy->mem_free   = ar->mem_free;
 
     size_t i;
     for (i = 0; i < copy->size; i++)
@@ -593,37 +1317,163 @@ enum cc_stat cc_array_filter_mut(CC_Array *ar, bool (*pred) (const void*))
     if (ar->size == 0)
         return CC_ERR_OUT_OF_RANGE;
 
-    size_t rm   = 0;
-    size_t keep = 0;
+    if (array_own_buffer(ar) != CC_OK)
+        return CC_ERR_ALLOC;
 
-    /* Look for clusters of non matching elements before moving
-     * in order to minimize the number of memmoves */
-    for (size_t i = ar->size - 1; i != ((size_t) - 1); i--) {
-        if (!pred(ar->buffer[i])) {
-            rm++;
-            continue;
-        }
-        if (rm > 0) {
-            if (keep > 0) {
-                size_t block_size = keep * sizeof(void*);
-                memmove(&(ar->buffer[i + 1]),
-                        &(ar->buffer[i + 1 + rm]),
-                        block_size);
-            }
-            ar->size -= rm;
-            rm = 0;
+    /* Single forward pass that moves each kept element at most once */
+    size_t write = 0;
+    for (size_t read = 0; read < ar->size; read++) {
+        if (pred(ar->buffer[read]))
+            ar->buffer[write++] = ar->buffer[read];
+    }
+    ar->size = write;
+    index_invalidate(ar);
+    shrink_capacity(ar);
+
+    return CC_OK;
+}
+
+/**
+ * Filters the CC_Array by modifying it without preserving the order of the
+ * remaining elements. Each removed element is replaced by the last element
+ * of the array, so every element is moved at most once.
+ *
+ * @param[in] ar   array that is to be filtered
+ * @param[in] pred predicate function which returns true if the element should
+ *                 be kept in the CC_Array
+ *
+ * @return CC_OK if the CC_Array was filtered successfully, or CC_ERR_OUT_OF_RANGE
+ * if the CC_Array is empty.
+ */
+enum cc_stat cc_array_filter_mut_unordered(CC_Array *ar, bool (*pred) (const void*))
+{
+    if (ar->size == 0)
+        return CC_ERR_OUT_OF_RANGE;
+
+    if (array_own_buffer(ar) != CC_OK)
+        return CC_ERR_ALLOC;
+
+    size_t i = 0;
+    while (i < ar->size) {
+        if (pred(ar->buffer[i]))
+            i++;
+        else
+            ar->buffer[i] = ar->buffer[--ar->size];
+    }
+    index_invalidate(ar);
+    ar->sorted_cmp = NULL;
+    shrink_capacity(ar);
+
+    return CC_OK;
+}
+
+/**
+ * Reorders the CC_Array so that all elements that return true on pred(element)
+ * precede the ones that do not, and sets split to the number of elements that
+ * returned true. The relative order of the elements is not preserved. The
+ * predicate is invoked exactly once on each element.
+ *
+ * @param[in] ar    array that is to be partitioned
+ * @param[in] pred  predicate function which returns true if the element
+ *                  belongs in the first part of the array
+ * @param[out] split pointer to where the index of the first element of the
+ *                   second part is stored
+ *
+ * @return CC_OK if the CC_Array was partitioned successfully, or CC_ERR_ALLOC
+ * if the array shares its buffer and the memory allocation for its own copy
+ * failed.
+ */
+enum cc_stat cc_array_partition(CC_Array *ar, bool (*pred) (const void*), size_t *split)
+{
+    if (array_own_buffer(ar) != CC_OK)
+        return CC_ERR_ALLOC;
+
+    size_t i = 0;
+    size_t j = ar->size;
+
+    /* Everything before i belongs in the first part and everything
+     * from j onwards in the second */
+    while (i < j) {
+        if (pred(ar->buffer[i])) {
+            i++;
+        } else {
+            j--;
+            void *tmp     = ar->buffer[i];
+            ar->buffer[i] = ar->buffer[j];
+            ar->buffer[j] = tmp;
         }
-        keep++;
     }
-    /* Remove any remaining elements*/
-    if (rm > 0) {
-        size_t block_size = keep * sizeof(void*);
-        memmove(&(ar->buffer[0]),
-                &(ar->buffer[rm]),
-                block_size);
+    *split = i;
+    index_invalidate(ar);
+    ar->sorted_cmp = NULL;
+
+    return CC_OK;
+}
+
+/**
+ * Reverses the order of the n elements in the buffer.
+ */
+static void buffer_reverse(void **buff, size_t n)
+{
+    size_t i;
+    size_t j;
+    for (i = 0, j = n - 1; i < j; i++, j--) {
+        void *tmp = buff[i];
+        buff[i] = buff[j];
+        buff[j] = tmp;
+    }
+}
 
-        ar->size -= rm;
+/**
+ * Stably partitions the n elements of the buffer in place by partitioning both
+ * halves and then rotating the first part of the second half in front of the
+ * second part of the first half.
+ *
+ * @return the number of elements in the first part.
+ */
+static size_t buffer_partition_stable(void **buff, size_t n, bool (*pred) (const void*))
+{
+    if (n == 1)
+        return pred(buff[0]) ? 1 : 0;
+
+    size_t mid   = n / 2;
+    size_t left  = buffer_partition_stable(buff, mid, pred);
+    size_t right = buffer_partition_stable(buff + mid, n - mid, pred);
+
+    if (left < mid && right > 0) {
+        buffer_reverse(buff + left, mid - left);
+        buffer_reverse(buff + mid, right);
+        buffer_reverse(buff + left, mid - left + right);
     }
+    return left + right;
+}
+
+/**
+ * Reorders the CC_Array so that all elements that return true on pred(element)
+ * precede the ones that do not, and sets split to the number of elements that
+ * returned true. The relative order of the elements within each part is
+ * preserved. The partitioning is done in place in O(n log n) time and the
+ * predicate is invoked exactly once on each element.
+ *
+ * @param[in] ar    array that is to be partitioned
+ * @param[in] pred  predicate function which returns true if the element
+ *                  belongs in the first part of the array
+ * @param[out] split pointer to where the index of the first element of the
+ *                   second part is stored
+ *
+ * @return CC_OK if the CC_Array was partitioned successfully, or CC_ERR_ALLOC
+ * if the array shares its buffer and the memory allocation for its own copy
+ * failed.
+ */
+enum cc_stat cc_array_partition_stable(CC_Array *ar, bool (*pred) (const void*), size_t *split)
+{
+    if (array_own_buffer(ar) != CC_OK)
+        return CC_ERR_ALLOC;
+
+    *split = ar->size ? buffer_partition_stable(ar->buffer, ar->size, pred) : 0;
+    index_invalidate(ar);
+    ar->sorted_cmp = NULL;
+
     return CC_OK;
 }
 
@@ -646,22 +1496,19 @@ enum cc_stat cc_array_filter(CC_Array *ar, bool (*pred) (const void*), CC_Array
     if (ar->size == 0)
         return CC_ERR_OUT_OF_RANGE;
 
-    CC_Array *filtered = ar->mem_alloc(sizeof(CC_Array));
+    CC_Array *filtered = array_calloc(ar, 1, array_struct_size(ar->inline_capacity));
 
     if (!filtered)
         return CC_ERR_ALLOC;
 
-    if (!(filtered->buffer = ar->mem_calloc(ar->capacity, sizeof(void*)))) {
-        ar->mem_free(filtered);
+    array_inherit_conf(ar, filtered);
+
+    if (!(filtered->buffer = buffer_alloc(filtered, ar->capacity))) {
+        array_free(ar, filtered);
         return CC_ERR_ALLOC;
     }
-
-    filtered->exp_factor = ar->exp_factor;
     filtered->size       = 0;
     filtered->capacity   = ar->capacity;
-    filtered->mem_alloc  = ar->mem_alloc;
-    filtered->mem_calloc = ar->mem_calloc;
-    filtered->mem_free   = ar->mem_free;
 
     size_t f = 0;
     for (size_t i = 0; i < ar->size; i++) {
@@ -675,6 +1522,75 @@ enum cc_stat cc_array_filter(CC_Array *ar, bool (*pred) (const void*), CC_Array
     return CC_OK;
 }
 
+/**
+ * Filters the CC_Array by appending all elements that return true on
+ * pred(element) to the dst CC_Array, without modifying the original CC_Array.
+ * The destination keeps its existing elements and its capacity is reused, so
+ * filtering into the same destination repeatedly stops allocating once the
+ * destination is large enough. Use <code>cc_array_count_if()</code> together
+ * with <code>cc_array_reserve()</code> to size the destination exactly.
+ *
+ * @param[in] ar   array that is to be filtered
+ * @param[in] pred predicate function which returns true if the element should
+ *                 be appended to the destination
+ * @param[in] dst  array to which the elements are appended, which may be the
+ *                 filtered array itself
+ *
+ * @return CC_OK if the CC_Array was filtered successfully, CC_ERR_ALLOC if the
+ * memory allocation for the destination buffer failed, or CC_ERR_MAX_CAPACITY
+ * if the destination cannot hold all the elements. Nothing is appended on
+ * failure.
+ */
+enum cc_stat cc_array_filter_into(CC_Array *ar, bool (*pred) (const void*), CC_Array *dst)
+{
+    size_t size = ar->size;
+    size_t dst_size = dst->size;
+
+    if (array_own_buffer(dst) != CC_OK)
+        return CC_ERR_ALLOC;
+
+    for (size_t i = 0; i < size; i++) {
+        if (!pred(ar->buffer[i]))
+            continue;
+
+        if (dst->size >= dst->capacity) {
+            enum cc_stat status = expand_capacity(dst);
+            if (status != CC_OK) {
+                dst->size = dst_size;
+                return status;
+            }
+        }
+        dst->buffer[dst->size++] = ar->buffer[i];
+    }
+    index_appended_from(dst, dst_size);
+
+    if (dst->size != dst_size)
+        dst->sorted_cmp = NULL;
+
+    return CC_OK;
+}
+
+/**
+ * Returns the number of elements in the CC_Array that return true on
+ * pred(element).
+ *
+ * @param[in] ar   array whose elements are being counted
+ * @param[in] pred predicate function which returns true if the element should
+ *                 be counted
+ *
+ * @return the number of matching elements.
+ */
+size_t cc_array_count_if(CC_Array *ar, bool (*pred) (const void*))
+{
+    size_t n = 0;
+    size_t i;
+    for (i = 0; i < ar->size; i++) {
+        if (pred(ar->buffer[i]))
+            n++;
+    }
+    return n;
+}
+
 /**
  * Reverses the order of elements in the specified array.
  *
@@ -682,7 +1598,7 @@ enum cc_stat cc_array_filter(CC_Array *ar, bool (*pred) (const void*), CC_Array
  */
 void cc_array_reverse(CC_Array *ar)
 {
-    if (ar->size == 0)
+    if (ar->size == 0 || array_own_buffer(ar) != CC_OK)
         return;
 
     size_t i;
@@ -692,6 +1608,8 @@ void cc_array_reverse(CC_Array *ar)
         ar->buffer[i] = ar->buffer[j];
         ar->buffer[j] = tmp;
     }
+    index_invalidate(ar);
+    ar->sorted_cmp = NULL;
 }
 
 /**
@@ -706,23 +1624,34 @@ void cc_array_reverse(CC_Array *ar)
  */
 enum cc_stat cc_array_trim_capacity(CC_Array *ar)
 {
-    if (ar->size == ar->capacity)
-        return CC_OK;
+    size_t new_capacity = ar->size < 1 ? 1 : ar->size;
 
-    void **new_buff = ar->mem_calloc(ar->size, sizeof(void*));
-
-    if (!new_buff)
-        return CC_ERR_ALLOC;
+    if (new_capacity == ar->capacity)
+        return CC_OK;
 
-    size_t size = ar->size < 1 ? 1 : ar->size;
+    return resize_buffer(ar, new_capacity);
+}
 
-    memcpy(new_buff, ar->buffer, size * sizeof(void*));
-    ar->mem_free(ar->buffer);
+/**
+ * Makes sure that the CC_Array can hold at least capacity elements without
+ * having to expand. The capacity is left as is if it is already large enough.
+ *
+ * @param[in] ar array whose capacity is being reserved
+ * @param[in] capacity the minimum capacity of the array
+ *
+ * @return CC_OK if the capacity was reserved successfully, CC_ERR_ALLOC if
+ * the memory allocation for the new buffer failed, or CC_ERR_MAX_CAPACITY
+ * if the capacity exceeds the maximum capacity of the array.
+ */
+enum cc_stat cc_array_reserve(CC_Array *ar, size_t capacity)
+{
+    if (capacity <= ar->capacity)
+        return CC_OK;
 
-    ar->buffer   = new_buff;
-    ar->capacity = ar->size;
+    if (capacity > CC_MAX_ELEMENTS)
+        return CC_ERR_MAX_CAPACITY;
 
-    return CC_OK;
+    return resize_buffer(ar, capacity);
 }
 
 /**
@@ -735,6 +1664,11 @@ enum cc_stat cc_array_trim_capacity(CC_Array *ar)
  */
 size_t cc_array_contains(CC_Array *ar, void *element)
 {
+    if (index_ready(ar)) {
+        ArrayIndexEntry *e = index_find(ar->index, element);
+        return e ? e->count : 0;
+    }
+
     size_t o = 0;
     size_t i;
     for (i = 0; i < ar->size; i++) {
@@ -746,7 +1680,9 @@ size_t cc_array_contains(CC_Array *ar, void *element)
 
 /**
  * Returns the number of occurrences of the value pointed to by <code>e</code>
- * within the specified CC_Array.
+ * within the specified CC_Array. If the array was marked as sorted by the same
+ * comparator with <code>cc_array_set_sorted()</code>, the occurrences are
+ * found with a binary search.
  *
  * @param[in] ar array that is being searched
  * @param[in] element the element that is being searched for
@@ -756,6 +1692,11 @@ size_t cc_array_contains(CC_Array *ar, void *element)
  */
 size_t cc_array_contains_value(CC_Array *ar, void *element, int (*cmp) (const void*, const void*))
 {
+    if (ar->sorted_cmp && ar->sorted_cmp == cmp) {
+        size_t first;
+        return cc_array_equal_range(ar, element, cmp, &first);
+    }
+
     size_t o = 0;
     size_t i;
     for (i = 0; i < ar->size; i++) {
@@ -766,12 +1707,179 @@ size_t cc_array_contains_value(CC_Array *ar, void *element, int (*cmp) (const vo
 }
 
 /**
- * Returns the size of the specified CC_Array. The size of the array is the
- * number of elements contained within the CC_Array.
+ * Marks the CC_Array as sorted in an ascending order by the specified
+ * comparator, or clears the mark if the comparator is NULL. The comparator
+ * receives the elements themselves, the same as the one passed to
+ * <code>cc_array_contains_value()</code>, which then switches to a binary
+ * search when it is given the same comparator. The mark is kept by removals
+ * and by <code>cc_array_add_sorted()</code> and is cleared by any other
+ * operation that may break the order.
  *
- * @param[in] ar array whose size is being returned
+ * @note Since <code>cc_array_sort()</code> passes pointers to the elements to
+ *       its comparator, sorting with it clears the mark and the array must
+ *       be marked again afterwards.
  *
- * @return the the number of element within the CC_Array.
+ * @param[in] ar the array that is being marked
+ * @param[in] cmp the comparator by which the array is sorted, or NULL
+ */
+void cc_array_set_sorted(CC_Array *ar, int (*cmp) (const void*, const void*))
+{
+    ar->sorted_cmp = cmp;
+}
+
+/**
+ * Returns the index of the first element of a sorted CC_Array that does not
+ * compare less than the specified element, or the size of the array if there
+ * is no such element.
+ *
+ * @param[in] ar the sorted array that is being searched
+ * @param[in] element the element that is being searched for
+ * @param[in] cmp comparator function that receives the searched element and
+ *                an array element, and returns a negative integer, zero or a
+ *                positive integer if the first is less than, equal to or
+ *                greater than the second
+ *
+ * @return the lower bound of the element.
+ */
+size_t cc_array_lower_bound(CC_Array *ar, void *element, int (*cmp) (const void*, const void*))
+{
+    size_t lo = 0;
+    size_t hi = ar->size;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (cmp(element, ar->buffer[mid]) > 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * Returns the index of the first element of a sorted CC_Array that compares
+ * greater than the specified element, or the size of the array if there is no
+ * such element.
+ *
+ * @param[in] ar the sorted array that is being searched
+ * @param[in] element the element that is being searched for
+ * @param[in] cmp comparator function with the same convention as the one of
+ *                <code>cc_array_lower_bound()</code>
+ *
+ * @return the upper bound of the element.
+ */
+size_t cc_array_upper_bound(CC_Array *ar, void *element, int (*cmp) (const void*, const void*))
+{
+    size_t lo = 0;
+    size_t hi = ar->size;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (cmp(element, ar->buffer[mid]) >= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * Finds the range of elements of a sorted CC_Array that compare equal to the
+ * specified element.
+ *
+ * @param[in] ar the sorted array that is being searched
+ * @param[in] element the element that is being searched for
+ * @param[in] cmp comparator function with the same convention as the one of
+ *                <code>cc_array_lower_bound()</code>
+ * @param[out] index pointer to where the index of the first equal element, or
+ *                   the position at which it would be inserted, is stored
+ *
+ * @return the number of elements equal to the searched element.
+ */
+size_t cc_array_equal_range(CC_Array *ar, void *element, int (*cmp) (const void*, const void*), size_t *index)
+{
+    size_t first = cc_array_lower_bound(ar, element, cmp);
+    size_t n     = 0;
+
+    /* Only the part after the lower bound needs to be searched */
+    if (first < ar->size && cmp(element, ar->buffer[first]) == 0) {
+        size_t lo = first + 1;
+        size_t hi = ar->size;
+
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+
+            if (cmp(element, ar->buffer[mid]) >= 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        n = lo - first;
+    }
+    *index = first;
+    return n;
+}
+
+/**
+ * Looks up the specified element in a sorted CC_Array with a binary search and
+ * sets the index parameter to the index of its first occurrence.
+ *
+ * @param[in] ar the sorted array that is being searched
+ * @param[in] element the element that is being searched for
+ * @param[in] cmp comparator function with the same convention as the one of
+ *                <code>cc_array_lower_bound()</code>
+ * @param[out] index pointer to where the index is stored
+ *
+ * @return CC_OK if the element was found, or CC_ERR_VALUE_NOT_FOUND if not.
+ */
+enum cc_stat cc_array_bsearch(CC_Array *ar, void *element, int (*cmp) (const void*, const void*), size_t *index)
+{
+    size_t i = cc_array_lower_bound(ar, element, cmp);
+
+    if (i == ar->size || cmp(element, ar->buffer[i]) != 0)
+        return CC_ERR_VALUE_NOT_FOUND;
+
+    *index = i;
+    return CC_OK;
+}
+
+/**
+ * Inserts the element into a sorted CC_Array after any elements that compare
+ * equal to it, so that the array stays sorted. The position is found with a
+ * binary search and the subsequent elements are shifted once. The sorted mark
+ * set with <code>cc_array_set_sorted()</code> is preserved if it was set with
+ * the same comparator, and cleared otherwise.
+ *
+ * @param[in] ar the sorted array to which the element is being added
+ * @param[in] element the element that is being added
+ * @param[in] cmp comparator function with the same convention as the one of
+ *                <code>cc_array_lower_bound()</code>
+ *
+ * @return CC_OK if the element was successfully added, CC_ERR_ALLOC if the
+ * memory allocation for the new element failed, or CC_ERR_MAX_CAPACITY if the
+ * array is already at maximum capacity.
+ */
+enum cc_stat cc_array_add_sorted(CC_Array *ar, void *element, int (*cmp) (const void*, const void*))
+{
+    int (*sorted_cmp) (const void*, const void*) = ar->sorted_cmp;
+
+    enum cc_stat status = cc_array_add_at(ar, element, cc_array_upper_bound(ar, element, cmp));
+
+    if (status == CC_OK && cmp == sorted_cmp)
+        ar->sorted_cmp = sorted_cmp;
+
+    return status;
+}
+
+/**
+ * Returns the size of the specified CC_Array. The size of the array is the
+ * number of elements contained within the CC_Array.
+ *
+ * @param[in] ar array whose size is being returned
+ *
+ * @return the the number of element within the CC_Array.
  */
 size_t cc_array_size(CC_Array *ar)
 {
@@ -779,59 +1887,3356 @@ size_t cc_array_size(CC_Array *ar)
 }
 
 /**
- * Returns the capacity of the specified CC_Array. The capacity of the CC_Array is
- * the maximum number of elements an CC_Array can hold before it has to be resized.
+ * Returns the capacity of the specified CC_Array. The capacity of the CC_Array is
+ * the maximum number of elements an CC_Array can hold before it has to be resized.
+ *
+ * @param[in] ar array whose capacity is being returned
+ *
+ * @return the capacity of the CC_Array.
+ */
+size_t cc_array_capacity(CC_Array *ar)
+{
+    return ar->capacity;
+}
+
+static INLINE void sort_swap(void **a, void **b)
+{
+    void *tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+/**
+ * Orders the three slots so that *a <= *b <= *c.
+ */
+static INLINE void sort_order3(void **a, void **b, void **c, sort_cmp_fn cmp)
+{
+    if (cmp(b, a) < 0)
+        sort_swap(a, b);
+    if (cmp(c, b) < 0) {
+        sort_swap(b, c);
+        if (cmp(b, a) < 0)
+            sort_swap(a, b);
+    }
+}
+
+static void sort_insertion(void **base, size_t n, sort_cmp_fn cmp)
+{
+    for (size_t i = 1; i < n; i++) {
+        void *tmp = base[i];
+        size_t j  = i;
+        for (; j > 0 && cmp(&tmp, &base[j - 1]) < 0; j--)
+            base[j] = base[j - 1];
+        base[j] = tmp;
+    }
+}
+
+/**
+ * Insertion sort that gives up once it has moved more than
+ * SORT_PARTIAL_INSERTION_LIMIT elements. Returns true if the buffer
+ * ended up sorted.
+ */
+static bool sort_partial_insertion(void **base, size_t n, sort_cmp_fn cmp)
+{
+    size_t moves = 0;
+
+    for (size_t i = 1; i < n; i++) {
+        if (cmp(&base[i], &base[i - 1]) >= 0)
+            continue;
+
+        void *tmp = base[i];
+        size_t j  = i;
+        do {
+            base[j] = base[j - 1];
+            j--;
+        } while (j > 0 && cmp(&tmp, &base[j - 1]) < 0);
+        base[j] = tmp;
+
+        moves += i - j;
+        if (moves > SORT_PARTIAL_INSERTION_LIMIT)
+            return false;
+    }
+    return true;
+}
+
+static void sort_sift_down(void **base, size_t root, size_t n, sort_cmp_fn cmp)
+{
+    void *tmp = base[root];
+
+    for (;;) {
+        size_t child = 2 * root + 1;
+        if (child >= n)
+            break;
+        if (child + 1 < n && cmp(&base[child], &base[child + 1]) < 0)
+            child++;
+        if (cmp(&tmp, &base[child]) >= 0)
+            break;
+        base[root] = base[child];
+        root = child;
+    }
+    base[root] = tmp;
+}
+
+static void sort_heap(void **base, size_t n, sort_cmp_fn cmp)
+{
+    for (size_t i = n / 2; i-- > 0;)
+        sort_sift_down(base, i, n, cmp);
+
+    for (size_t i = n; i-- > 1;) {
+        sort_swap(&base[0], &base[i]);
+        sort_sift_down(base, 0, i, cmp);
+    }
+}
+
+/**
+ * Partitions the buffer around the pivot at base[0], placing the elements
+ * equal to the pivot to its right. The pivot selection guarantees that an
+ * element not less than the pivot follows it, which lets the scans run
+ * without bounds checks. Returns the final position of the pivot and sets
+ * <code>partitioned</code> if no element had to be swapped.
+ */
+static size_t sort_partition_right(void **base, size_t n, sort_cmp_fn cmp, bool *partitioned)
+{
+    void *pivot = base[0];
+    size_t first = 0;
+    size_t last  = n;
+
+    while (cmp(&base[++first], &pivot) < 0);
+
+    if (first == 1) {
+        while (first < last && cmp(&base[--last], &pivot) >= 0);
+    } else {
+        while (cmp(&base[--last], &pivot) >= 0);
+    }
+
+    *partitioned = first >= last;
+
+    while (first < last) {
+        sort_swap(&base[first], &base[last]);
+        while (cmp(&base[++first], &pivot) < 0);
+        while (cmp(&base[--last], &pivot) >= 0);
+    }
+
+    size_t pivot_pos = first - 1;
+    base[0]         = base[pivot_pos];
+    base[pivot_pos] = pivot;
+
+    return pivot_pos;
+}
+
+/**
+ * Partitions the buffer around the pivot at base[0], placing the elements
+ * equal to the pivot to its left. Used when the pivot equals the element
+ * preceding the buffer, in which case the whole left part is already in
+ * place and only the right part is left to be sorted.
+ */
+static size_t sort_partition_left(void **base, size_t n, sort_cmp_fn cmp)
+{
+    void *pivot = base[0];
+    size_t first = 0;
+    size_t last  = n;
+
+    while (cmp(&pivot, &base[--last]) < 0);
+
+    if (last + 1 == n) {
+        while (first < last && cmp(&pivot, &base[++first]) >= 0);
+    } else {
+        while (cmp(&pivot, &base[++first]) >= 0);
+    }
+
+    while (first < last) {
+        sort_swap(&base[first], &base[last]);
+        while (cmp(&pivot, &base[--last]) < 0);
+        while (cmp(&pivot, &base[++first]) >= 0);
+    }
+
+    base[0]    = base[last];
+    base[last] = pivot;
+
+    return last;
+}
+
+/**
+ * Swaps a few elements of an unbalanced partition around in order to break
+ * the pattern that caused the bad pivot.
+ */
+static void sort_break_pattern(void **base, size_t n)
+{
+    if (n < SORT_INSERTION_THRESHOLD)
+        return;
+
+    size_t q = n / 4;
+    sort_swap(&base[0], &base[q]);
+    sort_swap(&base[n - 1], &base[n - q]);
+
+    if (n > SORT_NINTHER_THRESHOLD) {
+        sort_swap(&base[1], &base[q + 1]);
+        sort_swap(&base[2], &base[q + 2]);
+        sort_swap(&base[n - 2], &base[n - q - 1]);
+        sort_swap(&base[n - 3], &base[n - q - 2]);
+    }
+}
+
+/**
+ * Moves the median of three, or Tukey's ninther for larger partitions, to
+ * the front of the buffer as the pivot. Either way an element that is not
+ * less than the pivot is left behind it, as the partitioning requires.
+ */
+static void sort_choose_pivot(void **base, size_t n, sort_cmp_fn cmp)
+{
+    size_t half = n / 2;
+
+    if (n > SORT_NINTHER_THRESHOLD) {
+        sort_order3(&base[0], &base[half], &base[n - 1], cmp);
+        sort_order3(&base[1], &base[half - 1], &base[n - 2], cmp);
+        sort_order3(&base[2], &base[half + 1], &base[n - 3], cmp);
+        sort_order3(&base[half - 1], &base[half], &base[half + 1], cmp);
+        sort_swap(&base[0], &base[half]);
+    } else {
+        sort_order3(&base[half], &base[0], &base[n - 1], cmp);
+    }
+}
+
+/**
+ * Returns the number of bad partitions after which a sort, or a selection,
+ * of n elements switches to a heapsort.
+ */
+static unsigned sort_bad_allowed(size_t n)
+{
+    unsigned bad_allowed = 1;
+    for (size_t m = n; m > 1; m >>= 1)
+        bad_allowed++;
+    return bad_allowed;
+}
+
+static void sort_loop(void **base, size_t n, sort_cmp_fn cmp, unsigned bad_allowed, bool leftmost)
+{
+    while (n >= SORT_INSERTION_THRESHOLD) {
+        sort_choose_pivot(base, n, cmp);
+
+        /* If the pivot equals the preceding element, no element of this
+         * partition is smaller than the pivot, so the run of equal elements
+         * can be skipped altogether */
+        if (!leftmost && cmp(&base[-1], &base[0]) >= 0) {
+            size_t p = sort_partition_left(base, n, cmp) + 1;
+            base += p;
+            n    -= p;
+            continue;
+        }
+
+        bool partitioned;
+        size_t p = sort_partition_right(base, n, cmp, &partitioned);
+        size_t l = p;
+        size_t r = n - p - 1;
+
+        if (l < n / 8 || r < n / 8) {
+            /* Too many bad pivots, fall back to the guaranteed
+             * O(n log n) of a heapsort */
+            if (--bad_allowed == 0) {
+                sort_heap(base, n, cmp);
+                return;
+            }
+            sort_break_pattern(base, l);
+            sort_break_pattern(base + p + 1, r);
+        } else if (partitioned &&
+                   sort_partial_insertion(base, l, cmp) &&
+                   sort_partial_insertion(base + p + 1, r, cmp)) {
+            /* Both sides were already (nearly) sorted */
+            return;
+        }
+
+        /* Recurse into the smaller side and loop on the larger one so that
+         * the stack depth stays logarithmic */
+        if (l < r) {
+            sort_loop(base, l, cmp, bad_allowed, leftmost);
+            base    += p + 1;
+            n        = r;
+            leftmost = false;
+        } else {
+            sort_loop(base + p + 1, r, cmp, bad_allowed, false);
+            n = l;
+        }
+    }
+    sort_insertion(base, n, cmp);
+}
+
+/**
+ * Sorts the n element slots of the buffer with a pattern-defeating
+ * introsort. The comparator receives pointers to the slots, the same as
+ * with qsort().
+ */
+static void buffer_sort(void **base, size_t n, sort_cmp_fn cmp)
+{
+    sort_loop(base, n, cmp, sort_bad_allowed(n), true);
+}
+
+/**
+ * Rearranges the n slots of the buffer so that the slot nth holds the
+ * element that a sort would put there, with no greater elements before it
+ * and no smaller ones after it. This is an introselect: the partitioning of
+ * <code>sort_loop()</code> that only descends into the side holding nth,
+ * with a heapsort once too many partitions turn out unbalanced.
+ */
+static void buffer_select(void **base, size_t n, size_t nth, sort_cmp_fn cmp)
+{
+    unsigned bad_allowed = sort_bad_allowed(n);
+    bool leftmost        = true;
+
+    while (n >= SORT_INSERTION_THRESHOLD) {
+        sort_choose_pivot(base, n, cmp);
+
+        /* The slots up to the pivot all hold elements equal to it */
+        if (!leftmost && cmp(&base[-1], &base[0]) >= 0) {
+            size_t p = sort_partition_left(base, n, cmp);
+            if (nth <= p)
+                return;
+            base += p + 1;
+            n    -= p + 1;
+            nth  -= p + 1;
+            continue;
+        }
+
+        bool partitioned;
+        size_t p = sort_partition_right(base, n, cmp, &partitioned);
+        if (nth == p)
+            return;
+
+        size_t l = p;
+        size_t r = n - p - 1;
+
+        if (l < n / 8 || r < n / 8) {
+            if (--bad_allowed == 0) {
+                sort_heap(base, n, cmp);
+                return;
+            }
+            sort_break_pattern(base, l);
+            sort_break_pattern(base + p + 1, r);
+        }
+
+        if (nth < p) {
+            n = l;
+        } else {
+            base    += p + 1;
+            n        = r;
+            nth     -= p + 1;
+            leftmost = false;
+        }
+    }
+    sort_insertion(base, n, cmp);
+}
+
+/**
+ * A run of sorted elements of the stable sort that is waiting to be merged.
+ */
+typedef struct {
+    size_t base;
+    size_t len;
+} SortRun;
+
+/**
+ * State of a stable sort: the stack of pending runs and the scratch buffer
+ * used by the merges.
+ */
+typedef struct {
+    CC_Array const *ar;
+    sort_cmp_fn     cmp;
+    void          **base;
+    size_t          size;
+    void          **tmp;
+    size_t          tmp_cap;
+    bool            tmp_owned;
+    size_t          min_gallop;
+    size_t          n_runs;
+    SortRun         runs[SORT_MAX_RUNS];
+} SortMerge;
+
+/**
+ * Returns the length of the run at the start of the buffer, reversing it
+ * first if it is strictly descending. Strictness keeps equal elements in
+ * their original order.
+ */
+static size_t sort_count_run(void **base, size_t n, sort_cmp_fn cmp)
+{
+    if (n < 2)
+        return n;
+
+    size_t run = 2;
+    if (cmp(&base[1], &base[0]) < 0) {
+        while (run < n && cmp(&base[run], &base[run - 1]) < 0)
+            run++;
+        buffer_reverse(base, run);
+    } else {
+        while (run < n && cmp(&base[run], &base[run - 1]) >= 0)
+            run++;
+    }
+    return run;
+}
+
+/**
+ * Sorts the first n elements of the buffer, of which the first
+ * <code>start</code> are already sorted, with a binary insertion sort.
+ */
+static void sort_binary_insertion(void **base, size_t n, size_t start, sort_cmp_fn cmp)
+{
+    for (size_t i = start; i < n; i++) {
+        void *key = base[i];
+        size_t lo = 0;
+        size_t hi = i;
+
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (cmp(&key, &base[mid]) < 0)
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        memmove(&base[lo + 1], &base[lo], (i - lo) * sizeof(void*));
+        base[lo] = key;
+    }
+}
+
+/**
+ * Returns the minimum run length for a stable sort of n elements, chosen so
+ * that n / minrun is a power of two or slightly less than one.
+ */
+static size_t sort_min_run(size_t n)
+{
+    size_t r = 0;
+    while (n >= SORT_MIN_MERGE) {
+        r |= n & 1;
+        n >>= 1;
+    }
+    return n + r;
+}
+
+/**
+ * Returns the position of the first element of the sorted buffer that is not
+ * less than the key, searching outwards from the hint with exponentially
+ * growing steps before finishing with a binary search.
+ */
+static size_t sort_gallop_left(void *key, void **a, size_t n, size_t hint, sort_cmp_fn cmp)
+{
+    ptrdiff_t ofs     = 1;
+    ptrdiff_t lastofs = 0;
+    ptrdiff_t h       = (ptrdiff_t) hint;
+
+    if (cmp(&a[hint], &key) < 0) {
+        ptrdiff_t maxofs = (ptrdiff_t) n - h;
+        while (ofs < maxofs && cmp(&a[h + ofs], &key) < 0) {
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > maxofs)
+            ofs = maxofs;
+        lastofs += h;
+        ofs     += h;
+    } else {
+        ptrdiff_t maxofs = h + 1;
+        while (ofs < maxofs && cmp(&a[h - ofs], &key) >= 0) {
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > maxofs)
+            ofs = maxofs;
+        ptrdiff_t k = lastofs;
+        lastofs = h - ofs;
+        ofs     = h - k;
+    }
+
+    /* a[lastofs] < key <= a[ofs] */
+    lastofs++;
+    while (lastofs < ofs) {
+        ptrdiff_t m = lastofs + ((ofs - lastofs) >> 1);
+        if (cmp(&a[m], &key) < 0)
+            lastofs = m + 1;
+        else
+            ofs = m;
+    }
+    return (size_t) ofs;
+}
+
+/**
+ * Like <code>sort_gallop_left()</code>, but returns the position of the
+ * first element that is greater than the key.
+ */
+static size_t sort_gallop_right(void *key, void **a, size_t n, size_t hint, sort_cmp_fn cmp)
+{
+    ptrdiff_t ofs     = 1;
+    ptrdiff_t lastofs = 0;
+    ptrdiff_t h       = (ptrdiff_t) hint;
+
+    if (cmp(&key, &a[hint]) < 0) {
+        ptrdiff_t maxofs = h + 1;
+        while (ofs < maxofs && cmp(&key, &a[h - ofs]) < 0) {
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > maxofs)
+            ofs = maxofs;
+        ptrdiff_t k = lastofs;
+        lastofs = h - ofs;
+        ofs     = h - k;
+    } else {
+        ptrdiff_t maxofs = (ptrdiff_t) n - h;
+        while (ofs < maxofs && cmp(&key, &a[h + ofs]) >= 0) {
+            lastofs = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > maxofs)
+            ofs = maxofs;
+        lastofs += h;
+        ofs     += h;
+    }
+
+    /* a[lastofs] <= key < a[ofs] */
+    lastofs++;
+    while (lastofs < ofs) {
+        ptrdiff_t m = lastofs + ((ofs - lastofs) >> 1);
+        if (cmp(&key, &a[m]) < 0)
+            ofs = m;
+        else
+            lastofs = m + 1;
+    }
+    return (size_t) ofs;
+}
+
+/**
+ * Makes sure the scratch buffer can hold n elements. Since the shorter of
+ * two runs is copied, half of the sorted elements always suffice.
+ */
+static enum cc_stat sort_ensure_tmp(SortMerge *ms, size_t n)
+{
+    if (n <= ms->tmp_cap)
+        return CC_OK;
+
+    size_t cap = ms->size / 2 + 1;
+    void **tmp = array_alloc(ms->ar, cap * sizeof(void*));
+    if (!tmp)
+        return CC_ERR_ALLOC;
+
+    if (ms->tmp_owned)
+        array_free(ms->ar, ms->tmp);
+
+    ms->tmp       = tmp;
+    ms->tmp_cap   = cap;
+    ms->tmp_owned = true;
+
+    return CC_OK;
+}
+
+/**
+ * Merges the adjacent runs a and b, where a is the shorter one, from the
+ * front. Whenever one run wins SORT_MIN_GALLOP times in a row, the merge
+ * switches to galloping and copies whole blocks until both runs win again.
+ */
+static void sort_merge_lo(SortMerge *ms, void **a, size_t na, void **b, size_t nb)
+{
+    sort_cmp_fn cmp   = ms->cmp;
+    size_t min_gallop = ms->min_gallop;
+    void **dest       = a;
+    void **pa         = ms->tmp;
+    void **pb         = b;
+
+    memcpy(pa, a, na * sizeof(void*));
+
+    *dest++ = *pb++;
+    if (--nb == 0)
+        goto done;
+    if (na == 1)
+        goto copy_b;
+
+    for (;;) {
+        size_t acount = 0;
+        size_t bcount = 0;
+
+        /* Plain one-at-a-time merge until one run starts winning */
+        for (;;) {
+            if (cmp(pb, pa) < 0) {
+                *dest++ = *pb++;
+                bcount++;
+                acount = 0;
+                if (--nb == 0)
+                    goto done;
+                if (bcount >= min_gallop)
+                    break;
+            } else {
+                *dest++ = *pa++;
+                acount++;
+                bcount = 0;
+                if (--na == 1)
+                    goto copy_b;
+                if (acount >= min_gallop)
+                    break;
+            }
+        }
+
+        min_gallop++;
+        do {
+            min_gallop -= min_gallop > 1;
+            ms->min_gallop = min_gallop;
+
+            size_t k = sort_gallop_right(*pb, pa, na, 0, cmp);
+            acount = k;
+            if (k) {
+                memcpy(dest, pa, k * sizeof(void*));
+                dest += k;
+                pa   += k;
+                na   -= k;
+                if (na == 1)
+                    goto copy_b;
+                /* Only possible with an inconsistent comparator */
+                if (na == 0)
+                    goto done;
+            }
+            *dest++ = *pb++;
+            if (--nb == 0)
+                goto done;
+
+            k = sort_gallop_left(*pa, pb, nb, 0, cmp);
+            bcount = k;
+            if (k) {
+                memmove(dest, pb, k * sizeof(void*));
+                dest += k;
+                pb   += k;
+                nb   -= k;
+                if (nb == 0)
+                    goto done;
+            }
+            *dest++ = *pa++;
+            if (--na == 1)
+                goto copy_b;
+        } while (acount >= SORT_MIN_GALLOP || bcount >= SORT_MIN_GALLOP);
+
+        min_gallop++;
+        ms->min_gallop = min_gallop;
+    }
+
+done:
+    if (na)
+        memcpy(dest, pa, na * sizeof(void*));
+    return;
+
+copy_b:
+    /* The last element of a goes after the rest of b */
+    memmove(dest, pb, nb * sizeof(void*));
+    dest[nb] = *pa;
+}
+
+/**
+ * Merges the adjacent runs a and b, where b is the shorter one, from the
+ * back. Mirrors <code>sort_merge_lo()</code>.
+ */
+static void sort_merge_hi(SortMerge *ms, void **a, size_t na, void **b, size_t nb)
+{
+    sort_cmp_fn cmp   = ms->cmp;
+    size_t min_gallop = ms->min_gallop;
+    void **tmp        = ms->tmp;
+    void **dest       = b + nb - 1;
+    void **pa         = a + na - 1;
+    void **pb         = tmp + nb - 1;
+
+    memcpy(tmp, b, nb * sizeof(void*));
+
+    *dest-- = *pa--;
+    if (--na == 0)
+        goto done;
+    if (nb == 1)
+        goto copy_a;
+
+    for (;;) {
+        size_t acount = 0;
+        size_t bcount = 0;
+
+        for (;;) {
+            if (cmp(pb, pa) < 0) {
+                *dest-- = *pa--;
+                acount++;
+                bcount = 0;
+                if (--na == 0)
+                    goto done;
+                if (acount >= min_gallop)
+                    break;
+            } else {
+                *dest-- = *pb--;
+                bcount++;
+                acount = 0;
+                if (--nb == 1)
+                    goto copy_a;
+                if (bcount >= min_gallop)
+                    break;
+            }
+        }
+
+        min_gallop++;
+        do {
+            min_gallop -= min_gallop > 1;
+            ms->min_gallop = min_gallop;
+
+            size_t k = na - sort_gallop_right(*pb, a, na, na - 1, cmp);
+            acount = k;
+            if (k) {
+                dest -= k;
+                pa   -= k;
+                memmove(dest + 1, pa + 1, k * sizeof(void*));
+                na -= k;
+                if (na == 0)
+                    goto done;
+            }
+            *dest-- = *pb--;
+            if (--nb == 1)
+                goto copy_a;
+
+            k = nb - sort_gallop_left(*pa, tmp, nb, nb - 1, cmp);
+            bcount = k;
+            if (k) {
+                dest -= k;
+                pb   -= k;
+                memcpy(dest + 1, pb + 1, k * sizeof(void*));
+                nb -= k;
+                if (nb == 1)
+                    goto copy_a;
+                /* Only possible with an inconsistent comparator */
+                if (nb == 0)
+                    goto done;
+            }
+            *dest-- = *pa--;
+            if (--na == 0)
+                goto done;
+        } while (acount >= SORT_MIN_GALLOP || bcount >= SORT_MIN_GALLOP);
+
+        min_gallop++;
+        ms->min_gallop = min_gallop;
+    }
+
+done:
+    if (nb)
+        memcpy(dest - (nb - 1), tmp, nb * sizeof(void*));
+    return;
+
+copy_a:
+    /* The first element of b goes before the rest of a */
+    dest -= na;
+    pa   -= na;
+    memmove(dest + 1, pa + 1, na * sizeof(void*));
+    *dest = *pb;
+}
+
+/**
+ * Merges the runs i and i + 1 of the stack.
+ */
+static enum cc_stat sort_merge_at(SortMerge *ms, size_t i)
+{
+    void **a  = ms->base + ms->runs[i].base;
+    size_t na = ms->runs[i].len;
+    void **b  = ms->base + ms->runs[i + 1].base;
+    size_t nb = ms->runs[i + 1].len;
+
+    /* The elements of a that are not greater than the first one of b, and
+     * the elements of b that are not less than the last one of a, are
+     * already in place */
+    size_t k = sort_gallop_right(*b, a, na, 0, ms->cmp);
+    a  += k;
+    na -= k;
+    if (na)
+        nb = sort_gallop_left(a[na - 1], b, nb, nb - 1, ms->cmp);
+
+    if (na && nb) {
+        if (sort_ensure_tmp(ms, na < nb ? na : nb) != CC_OK)
+            return CC_ERR_ALLOC;
+
+        if (na <= nb)
+            sort_merge_lo(ms, a, na, b, nb);
+        else
+            sort_merge_hi(ms, a, na, b, nb);
+    }
+
+    ms->runs[i].len += ms->runs[i + 1].len;
+    if (i + 3 == ms->n_runs)
+        ms->runs[i + 1] = ms->runs[i + 2];
+    ms->n_runs--;
+
+    return CC_OK;
+}
+
+/**
+ * Merges runs at the top of the stack until the lengths of the pending runs
+ * decrease at least as fast as the Fibonacci numbers, which keeps the merges
+ * balanced and the stack short.
+ */
+static enum cc_stat sort_merge_collapse(SortMerge *ms)
+{
+    SortRun *r = ms->runs;
+
+    while (ms->n_runs > 1) {
+        size_t i = ms->n_runs - 2;
+
+        if ((i > 0 && r[i - 1].len <= r[i].len + r[i + 1].len) ||
+            (i > 1 && r[i - 2].len <= r[i - 1].len + r[i].len)) {
+            if (r[i - 1].len < r[i + 1].len)
+                i--;
+        } else if (r[i].len > r[i + 1].len) {
+            break;
+        }
+
+        enum cc_stat status = sort_merge_at(ms, i);
+        if (status != CC_OK)
+            return status;
+    }
+    return CC_OK;
+}
+
+/**
+ * Stable sort of the n slots of the buffer that merges natural runs. The
+ * scratch buffer is used for the merges if it is large enough, otherwise
+ * one is allocated with the allocators of the array.
+ */
+static enum cc_stat buffer_sort_stable(CC_Array const *ar, void **base, size_t n,
+                                       sort_cmp_fn cmp, void **scratch, size_t scratch_size)
+{
+    SortMerge ms;
+    ms.ar         = ar;
+    ms.cmp        = cmp;
+    ms.base       = base;
+    ms.size       = n;
+    ms.tmp        = scratch;
+    ms.tmp_cap    = scratch ? scratch_size : 0;
+    ms.tmp_owned  = false;
+    ms.min_gallop = SORT_MIN_GALLOP;
+    ms.n_runs     = 0;
+
+    size_t min_run     = sort_min_run(n);
+    size_t lo          = 0;
+    enum cc_stat status = CC_OK;
+
+    while (lo < n && status == CC_OK) {
+        size_t remaining = n - lo;
+        size_t run       = sort_count_run(base + lo, remaining, cmp);
+
+        /* Extend short runs to the minimum length */
+        if (run < min_run) {
+            size_t force = remaining < min_run ? remaining : min_run;
+            sort_binary_insertion(base + lo, force, run, cmp);
+            run = force;
+        }
+
+        ms.runs[ms.n_runs].base = lo;
+        ms.runs[ms.n_runs].len  = run;
+        ms.n_runs++;
+
+        status = sort_merge_collapse(&ms);
+        lo += run;
+    }
+
+    /* Merge whatever is left on the stack */
+    while (ms.n_runs > 1 && status == CC_OK) {
+        size_t i = ms.n_runs - 2;
+        if (i > 0 && ms.runs[i - 1].len < ms.runs[i + 1].len)
+            i--;
+        status = sort_merge_at(&ms, i);
+    }
+
+    if (ms.tmp_owned)
+        array_free(ar, ms.tmp);
+
+    return status;
+}
+
+#ifdef CC_ARRAY_THREADS
+
+/**
+ * Part of a parallel sort that runs on its own thread: either sorting the
+ * slots of a in place, when dst is NULL, or merging a and b into dst.
+ */
+typedef struct {
+    sort_cmp_fn cmp;
+    void      **a;
+    size_t      na;
+    void      **b;
+    size_t      nb;
+    void      **dst;
+} SortTask;
+
+static void *sort_task_run(void *arg)
+{
+    SortTask *t = arg;
+
+    if (!t->dst) {
+        buffer_sort(t->a, t->na, t->cmp);
+        return NULL;
+    }
+
+    void **a     = t->a;
+    void **b     = t->b;
+    void **a_end = a + t->na;
+    void **b_end = b + t->nb;
+    void **dst   = t->dst;
+
+    /* Ties are taken from a, which keeps the merge stable */
+    while (a < a_end && b < b_end) {
+        if (t->cmp(b, a) < 0)
+            *dst++ = *b++;
+        else
+            *dst++ = *a++;
+    }
+    memcpy(dst, a, (a_end - a) * sizeof(void*));
+    dst += a_end - a;
+    memcpy(dst, b, (b_end - b) * sizeof(void*));
+
+    return NULL;
+}
+
+/**
+ * Returns how many of the first k elements of the stable merge of the
+ * sorted buffers a and b come from a. This lets independent threads merge
+ * disjoint stretches of the output.
+ */
+static size_t sort_co_rank(size_t k, void **a, size_t na, void **b, size_t nb, sort_cmp_fn cmp)
+{
+    size_t lo = k > nb ? k - nb : 0;
+    size_t hi = k < na ? k : na;
+
+    while (lo < hi) {
+        size_t i = lo + (hi - lo) / 2;
+        if (cmp(&a[i], &b[k - i - 1]) <= 0)
+            lo = i + 1;
+        else
+            hi = i;
+    }
+    return lo;
+}
+
+/**
+ * Runs the tasks, the first one on the calling thread and the rest on
+ * threads of their own. A task whose thread cannot be created is run on the
+ * calling thread instead.
+ */
+static void sort_run_tasks(SortTask *tasks, size_t n)
+{
+    pthread_t threads[SORT_PARALLEL_MAX_THREADS + 1];
+    bool      started[SORT_PARALLEL_MAX_THREADS + 1];
+
+    for (size_t i = 1; i < n; i++) {
+        started[i] = pthread_create(&threads[i], NULL, sort_task_run, &tasks[i]) == 0;
+        if (!started[i])
+            sort_task_run(&tasks[i]);
+    }
+    sort_task_run(&tasks[0]);
+
+    for (size_t i = 1; i < n; i++) {
+        if (started[i])
+            pthread_join(threads[i], NULL);
+    }
+}
+
+/**
+ * Returns the start of the chunk i of n elements split into the given number
+ * of nearly equal chunks.
+ */
+static INLINE size_t sort_chunk_start(size_t n, size_t chunks, size_t i)
+{
+    return n / chunks * i + (i < n % chunks ? i : n % chunks);
+}
+
+/**
+ * Sorts the n slots of the buffer with the given number of threads. Each
+ * thread first sorts a chunk of its own, after which adjacent chunks are
+ * merged pairwise back and forth between the buffer and the scratch buffer,
+ * with every merge split between several threads.
+ */
+static void buffer_sort_parallel(void **base, void **scratch, size_t n, sort_cmp_fn cmp, size_t threads)
+{
+    SortTask tasks[SORT_PARALLEL_MAX_THREADS + 1];
+    size_t   bounds[SORT_PARALLEL_MAX_THREADS + 1];
+    size_t   runs = threads;
+
+    for (size_t i = 0; i < runs; i++) {
+        bounds[i]    = sort_chunk_start(n, runs, i);
+        tasks[i].cmp = cmp;
+        tasks[i].a   = base + bounds[i];
+        tasks[i].na  = sort_chunk_start(n, runs, i + 1) - bounds[i];
+        tasks[i].dst = NULL;
+    }
+    bounds[runs] = n;
+    sort_run_tasks(tasks, runs);
+
+    void **src = base;
+    void **dst = scratch;
+
+    while (runs > 1) {
+        size_t pairs    = runs / 2;
+        size_t per_pair = threads / pairs;
+        size_t n_tasks  = 0;
+
+        for (size_t p = 0; p < pairs; p++) {
+            size_t lo    = bounds[2 * p];
+            size_t mid   = bounds[2 * p + 1];
+            size_t total = bounds[2 * p + 2] - lo;
+            void **a     = src + lo;
+            void **b     = src + mid;
+            size_t na    = mid - lo;
+            size_t nb    = total - na;
+
+            for (size_t s = 0; s < per_pair; s++) {
+                size_t k0 = sort_chunk_start(total, per_pair, s);
+                size_t k1 = sort_chunk_start(total, per_pair, s + 1);
+                size_t i0 = sort_co_rank(k0, a, na, b, nb, cmp);
+                size_t i1 = sort_co_rank(k1, a, na, b, nb, cmp);
+
+                SortTask *t = &tasks[n_tasks++];
+                t->cmp = cmp;
+                t->a   = a + i0;
+                t->na  = i1 - i0;
+                t->b   = b + (k0 - i0);
+                t->nb  = (k1 - i1) - (k0 - i0);
+                t->dst = dst + lo + k0;
+            }
+        }
+
+        /* An odd run out is merged with nothing, which copies it over */
+        if (runs % 2) {
+            SortTask *t = &tasks[n_tasks++];
+            t->cmp = cmp;
+            t->a   = src + bounds[runs - 1];
+            t->na  = n - bounds[runs - 1];
+            t->b   = t->a + t->na;
+            t->nb  = 0;
+            t->dst = dst + bounds[runs - 1];
+        }
+        sort_run_tasks(tasks, n_tasks);
+
+        runs = (runs + 1) / 2;
+        for (size_t i = 0; i < runs; i++)
+            bounds[i] = bounds[2 * i];
+        bounds[runs] = n;
+
+        void **tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != base)
+        memcpy(base, src, n * sizeof(void*));
+}
+
+#endif /* CC_ARRAY_THREADS */
+
+/**
+ * An element of an array sorted by key, next to its extracted key.
+ */
+typedef struct {
+    uint64_t key;
+    void    *ptr;
+} SortKeyed;
+
+/**
+ * Stable LSD radix sort of the n pairs by key, one byte per pass. All the
+ * histograms are counted in a single pass over the keys, and passes over a
+ * byte that is the same for all keys are skipped. Returns the buffer, either
+ * pairs or tmp, that holds the sorted pairs.
+ */
+static SortKeyed *sort_radix(SortKeyed *pairs, SortKeyed *tmp, size_t n)
+{
+    size_t counts[SORT_RADIX_PASSES][SORT_RADIX_BUCKETS] = {{0}};
+
+    for (size_t i = 0; i < n; i++) {
+        uint64_t key = pairs[i].key;
+        for (size_t p = 0; p < SORT_RADIX_PASSES; p++)
+            counts[p][(key >> (p * 8)) & (SORT_RADIX_BUCKETS - 1)]++;
+    }
+
+    SortKeyed *src = pairs;
+    SortKeyed *dst = tmp;
+
+    for (size_t p = 0; p < SORT_RADIX_PASSES; p++) {
+        size_t *count = counts[p];
+        unsigned shift = p * 8;
+
+        if (count[(src[0].key >> shift) & (SORT_RADIX_BUCKETS - 1)] == n)
+            continue;
+
+        /* Turn the counts into the starting offsets of the buckets */
+        size_t offset = 0;
+        for (size_t b = 0; b < SORT_RADIX_BUCKETS; b++) {
+            size_t c = count[b];
+            count[b] = offset;
+            offset  += c;
+        }
+
+        for (size_t i = 0; i < n; i++)
+            dst[count[(src[i].key >> shift) & (SORT_RADIX_BUCKETS - 1)]++] = src[i];
+
+        SortKeyed *swap = src;
+        src = dst;
+        dst = swap;
+    }
+    return src;
+}
+
+/**
+ * Sorts the specified array in place with a pattern-defeating introsort,
+ * which runs in linear time on sorted, reverse sorted and all-equal input
+ * and in O(n log n) in the worst case. The sort is not stable.
+ *
+ * @note
+ * Pointers passed to the comparator function will be pointers to the array
+ * elements that are of type (void*) ie. void**. So an extra step of
+ * dereferencing will be required before the data can be used for comparison:
+ * eg. <code>my_type e = *(*((my_type**) ptr));</code>.
+ *
+ * @code
+ * enum cc_stat mycmp(const void *e1, const void *e2) {
+ *     MyType el1 = *(*((enum cc_stat**) e1));
+ *     MyType el2 = *(*((enum cc_stat**) e2));
+ *
+ *     if (el1 < el2) return -1;
+ *     if (el1 > el2) return 1;
+ *     return 0;
+ * }
+ *
+ * ...
+ *
+ * cc_array_sort(array, mycmp);
+ * @endcode
+ *
+ * @param[in] ar  array to be sorted
+ * @param[in] cmp the comparator function that must be of type <code>
+ *                enum cc_stat cmp(const void e1*, const void e2*)</code> that
+ *                returns < 0 if the first element goes before the second,
+ *                0 if the elements are equal and > 0 if the second goes
+ *                before the first
+ */
+void cc_array_sort(CC_Array *ar, int (*cmp) (const void*, const void*))
+{
+    if (array_own_buffer(ar) != CC_OK)
+        return;
+
+    buffer_sort(ar->buffer, ar->size, cmp);
+    index_invalidate(ar);
+    ar->sorted_cmp = NULL;
+}
+
+/**
+ * Rearranges the specified array so that the element at the given index is
+ * the one that would be there if the array were sorted, every element
+ * before it does not go after it and every element after it does not go
+ * before it. This takes linear time on average, and O(n log n) at worst,
+ * instead of the O(n log n) of a full sort. The comparator follows the same
+ * convention as the one of <code>cc_array_sort()</code>.
+ *
+ * @param[in] ar  array that is being rearranged
+ * @param[in] index the index of the element that is being selected
+ * @param[in] cmp the comparator function
+ *
+ * @return CC_OK if the element was selected, CC_ERR_OUT_OF_RANGE if the
+ * index is not within the bounds of the array, or CC_ERR_ALLOC if the array
+ * shares its buffer with a copy and the buffer could not be unshared.
+ */
+enum cc_stat cc_array_select_nth(CC_Array *ar, size_t index, int (*cmp) (const void*, const void*))
+{
+    if (index >= ar->size)
+        return CC_ERR_OUT_OF_RANGE;
+
+    if (array_own_buffer(ar) != CC_OK)
+        return CC_ERR_ALLOC;
+
+    buffer_select(ar->buffer, ar->size, index, cmp);
+    index_invalidate(ar);
+    ar->sorted_cmp = NULL;
+
+    return CC_OK;
+}
+
+/**
+ * Sorts the first k elements of the specified array, so that they are the
+ * same as the first k elements of the fully sorted array. The order of the
+ * remaining elements is unspecified. The first k elements are selected in
+ * linear time on average and then sorted, which takes O(n + k log k)
+ * instead of the O(n log n) of a full sort. The comparator follows the same
+ * convention as the one of <code>cc_array_sort()</code>.
+ *
+ * @param[in] ar  array that is being partially sorted
+ * @param[in] k   the number of elements to sort
+ * @param[in] cmp the comparator function
+ *
+ * @return CC_OK if the elements were sorted, CC_ERR_OUT_OF_RANGE if k is
+ * greater than the size of the array, or CC_ERR_ALLOC if the array shares
+ * its buffer with a copy and the buffer could not be unshared.
+ */
+enum cc_stat cc_array_partial_sort(CC_Array *ar, size_t k, int (*cmp) (const void*, const void*))
+{
+    if (k > ar->size)
+        return CC_ERR_OUT_OF_RANGE;
+
+    if (array_own_buffer(ar) != CC_OK)
+        return CC_ERR_ALLOC;
+
+    if (k > 0) {
+        /* Everything after the selected element is already out of the way */
+        buffer_select(ar->buffer, ar->size, k - 1, cmp);
+        buffer_sort(ar->buffer, k - 1, cmp);
+    }
+    index_invalidate(ar);
+    ar->sorted_cmp = NULL;
+
+    return CC_OK;
+}
+
+/**
+ * Appends the k elements of the specified array that would come first if it
+ * were sorted to the destination array, in sorted order, leaving the
+ * specified array untouched. The elements are found in a single pass with a
+ * heap of k elements built in the free space of the destination array, which
+ * takes O(n log k) time and no extra memory. To find the k greatest elements,
+ * pass a comparator that orders the elements in descending order. The
+ * comparator follows the same convention as the one of
+ * <code>cc_array_sort()</code>.
+ *
+ * If the array has fewer than k elements, all of them are appended.
+ *
+ * @param[in] ar  array whose elements are being selected
+ * @param[in] k   the number of elements to select
+ * @param[in] cmp the comparator function
+ * @param[in] dst the array to which the selected elements are appended
+ *
+ * @return CC_OK if the elements were appended, CC_ERR_ALLOC if the memory
+ * allocation for the new elements failed, or CC_ERR_MAX_CAPACITY if the
+ * destination array cannot hold that many elements.
+ */
+enum cc_stat cc_array_top_k(CC_Array *ar, size_t k, int (*cmp) (const void*, const void*), CC_Array *dst)
+{
+    size_t size = ar->size;
+    size_t m    = k < size ? k : size;
+
+    if (m == 0)
+        return CC_OK;
+
+    enum cc_stat status = ensure_capacity(dst, m);
+    if (status != CC_OK)
+        return status;
+
+    /* The heap lives past the end of dst, so ar may be dst itself */
+    void **heap = dst->buffer + dst->size;
+    memcpy(heap, ar->buffer, m * sizeof(void*));
+
+    for (size_t i = m / 2; i-- > 0;)
+        sort_sift_down(heap, i, m, cmp);
+
+    /* The root of the max-heap is the last of the k elements found so far */
+    for (size_t i = m; i < size; i++) {
+        if (cmp(&ar->buffer[i], &heap[0]) < 0) {
+            heap[0] = ar->buffer[i];
+            sort_sift_down(heap, 0, m, cmp);
+        }
+    }
+
+    for (size_t i = m; i-- > 1;) {
+        sort_swap(&heap[0], &heap[i]);
+        sort_sift_down(heap, 0, i, cmp);
+    }
+
+    dst->size += m;
+    index_appended_from(dst, dst->size - m);
+    dst->sorted_cmp = NULL;
+
+    return CC_OK;
+}
+
+/**
+ * Sorts the specified array using several threads. The array is split into
+ * one chunk per thread, the chunks are sorted concurrently with the same
+ * algorithm as <code>cc_array_sort()</code>, and then merged in parallel
+ * with a stable merge. When the comparator is a total order, the result is
+ * identical to that of <code>cc_array_sort()</code>.
+ *
+ * Each thread is given at least 32768 elements, so smaller arrays, or
+ * platforms without POSIX threads, are sorted serially on the calling
+ * thread. The merges need a scratch buffer as large as the array, allocated
+ * with the memory allocators of the array; if that allocation fails the
+ * array is sorted serially as well.
+ *
+ * @param[in] ar  array to be sorted
+ * @param[in] cmp the comparator function, which must be safe to call from
+ *                several threads at once
+ * @param[in] nthreads the maximum number of threads to use, or 0 to use one
+ *                     per online processor
+ *
+ * @return CC_OK if the array was sorted, or CC_ERR_ALLOC if the array shares
+ * its buffer with a copy and the buffer could not be unshared.
+ */
+enum cc_stat cc_array_sort_parallel(CC_Array *ar, int (*cmp) (const void*, const void*), size_t nthreads)
+{
+    if (array_own_buffer(ar) != CC_OK)
+        return CC_ERR_ALLOC;
+
+#ifdef CC_ARRAY_THREADS
+    if (nthreads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads  = cpus > 0 ? (size_t) cpus : 1;
+    }
+    if (nthreads > SORT_PARALLEL_MAX_THREADS)
+        nthreads = SORT_PARALLEL_MAX_THREADS;
+    if (nthreads > ar->size / SORT_PARALLEL_MIN_CHUNK)
+        nthreads = ar->size / SORT_PARALLEL_MIN_CHUNK;
+
+    if (nthreads > 1) {
+        void **scratch = array_alloc(ar, ar->size * sizeof(void*));
+        if (scratch) {
+            buffer_sort_parallel(ar->buffer, scratch, ar->size, cmp, nthreads);
+            array_free(ar, scratch);
+            index_invalidate(ar);
+            ar->sorted_cmp = NULL;
+            return CC_OK;
+        }
+    }
+#else
+    (void) nthreads;
+#endif /* CC_ARRAY_THREADS */
+
+    cc_array_sort(ar, cmp);
+    return CC_OK;
+}
+
+/**
+ * Sorts the specified array by an unsigned integer key of its elements while
+ * preserving the relative order of elements with equal keys. The key of each
+ * element is extracted only once, after which the keys are sorted together
+ * with the elements by a least significant digit radix sort, one byte at a
+ * time. No comparisons are made, and the elements are not dereferenced
+ * again, so this is usually much faster than sorting with a comparator that
+ * reads the same key through the element pointers.
+ *
+ * Keys are ordered as unsigned integers. A signed key <code>k</code> can be
+ * mapped to one with the same order as <code>(uint64_t) k ^ (1ull << 63)</code>.
+ * Bytes that are equal in all keys cost no pass, so small keys are sorted in
+ * fewer passes.
+ *
+ * The sort needs two buffers of key and element pairs as long as the array,
+ * which are allocated with the memory allocators of the array.
+ *
+ * @param[in] ar  array to be sorted
+ * @param[in] key function that returns the key of the element it is passed
+ *
+ * @return CC_OK if the array was sorted, or CC_ERR_ALLOC if the memory
+ * allocation failed, in which case the array is left unchanged.
+ */
+enum cc_stat cc_array_sort_by_key(CC_Array *ar, uint64_t (*key) (const void*))
+{
+    if (array_own_buffer(ar) != CC_OK)
+        return CC_ERR_ALLOC;
+
+    size_t n = ar->size;
+    if (n < 2)
+        return CC_OK;
+    if (n > SIZE_MAX / (2 * sizeof(SortKeyed)))
+        return CC_ERR_ALLOC;
+
+    SortKeyed *pairs = array_alloc(ar, 2 * n * sizeof(SortKeyed));
+    if (!pairs)
+        return CC_ERR_ALLOC;
+
+    for (size_t i = 0; i < n; i++) {
+        pairs[i].key = key(ar->buffer[i]);
+        pairs[i].ptr = ar->buffer[i];
+    }
+
+    SortKeyed *sorted = sort_radix(pairs, pairs + n, n);
+
+    for (size_t i = 0; i < n; i++)
+        ar->buffer[i] = sorted[i].ptr;
+
+    array_free(ar, pairs);
+    index_invalidate(ar);
+    ar->sorted_cmp = NULL;
+
+    return CC_OK;
+}
+
+/**
+ * Sorts the specified array while preserving the relative order of equal
+ * elements. The sort detects the runs of already sorted (or strictly
+ * descending) elements and merges them, galloping through long stretches
+ * that come from one run, so input that consists of a few sorted runs is
+ * sorted in close to linear time. The comparator follows the same convention
+ * as the one of <code>cc_array_sort()</code>.
+ *
+ * The merges need a scratch buffer of up to half the size of the array,
+ * which is allocated with the memory allocators of the array.
+ *
+ * @param[in] ar  array to be sorted
+ * @param[in] cmp the comparator function
+ *
+ * @return CC_OK if the array was sorted, or CC_ERR_ALLOC if the scratch
+ * buffer could not be allocated, in which case the array holds the same
+ * elements in an unspecified order.
+ */
+enum cc_stat cc_array_sort_stable(CC_Array *ar, int (*cmp) (const void*, const void*))
+{
+    return cc_array_sort_stable_scratch(ar, cmp, NULL, 0);
+}
+
+/**
+ * Like <code>cc_array_sort_stable()</code>, but uses the scratch buffer
+ * supplied by the caller for the merges. A scratch buffer that can hold half
+ * of the elements of the array is always large enough. If the buffer turns
+ * out to be too small, or is NULL, a larger one is allocated with the memory
+ * allocators of the array.
+ *
+ * @param[in] ar  array to be sorted
+ * @param[in] cmp the comparator function
+ * @param[in] scratch the scratch buffer, or NULL
+ * @param[in] scratch_size the number of elements the scratch buffer can hold
+ *
+ * @return CC_OK if the array was sorted, or CC_ERR_ALLOC if the scratch
+ * buffer could not be allocated, in which case the array holds the same
+ * elements in an unspecified order.
+ */
+enum cc_stat cc_array_sort_stable_scratch(CC_Array *ar, int (*cmp) (const void*, const void*),
+                                          void **scratch, size_t scratch_size)
+{
+    if (array_own_buffer(ar) != CC_OK)
+        return CC_ERR_ALLOC;
+
+    enum cc_stat status = buffer_sort_stable(ar, ar->buffer, ar->size, cmp, scratch, scratch_size);
+
+    index_invalidate(ar);
+    ar->sorted_cmp = NULL;
+
+    return status;
+}
+
+/**
+ * Expands the CC_Array capacity according to its growth strategy. This might
+ * fail if the the new buffer cannot be allocated. In case the expansion would
+ * overflow the index range, a maximum capacity buffer is allocated instead.
+ * If the capacity is already at the maximum capacity, no new buffer is
+ * allocated.
+ *
+ * @param[in] ar array whose capacity is being expanded
+ *
+ * @return CC_OK if the buffer was expanded successfully, CC_ERR_ALLOC if
+ * the memory allocation for the new buffer failed, or CC_ERR_MAX_CAPACITY
+ * if the array is already at maximum capacity.
+ */
+static enum cc_stat expand_capacity(CC_Array *ar)
+{
+    if (ar->capacity == CC_MAX_ELEMENTS)
+        return CC_ERR_MAX_CAPACITY;
+
+    size_t new_capacity = grow_capacity(ar);
+
+    /* As long as the capacity is greater that the expansion factor
+     * at the point of overflow, this is check is valid. */
+    if (new_capacity <= ar->capacity)
+        new_capacity = CC_MAX_ELEMENTS;
+
+    enum cc_stat status = resize_buffer(ar, new_capacity);
+
+    if (status == CC_OK && ar->growth == CC_ARRAY_GROWTH_SIZE_CLASS)
+        claim_slack(ar);
+
+    return status;
+}
+
+/**
+ * Makes room for n more elements in the CC_Array with a single expansion. The
+ * capacity grows at least as much as it would on a regular expansion, so that
+ * repeated bulk additions remain amortized.
+ *
+ * @param[in] ar array whose capacity is being ensured
+ * @param[in] n number of elements that are about to be added
+ *
+ * @return CC_OK if the array can hold the new elements, CC_ERR_ALLOC if the
+ * memory allocation for the new buffer failed, or CC_ERR_MAX_CAPACITY if
+ * the elements would not fit into the maximum capacity.
+ */
+static enum cc_stat ensure_capacity(CC_Array *ar, size_t n)
+{
+    if (n > CC_MAX_ELEMENTS - ar->size)
+        return CC_ERR_MAX_CAPACITY;
+
+    size_t needed = ar->size + n;
+
+    if (needed <= ar->capacity)
+        return array_own_buffer(ar);
+
+    size_t new_capacity = grow_capacity(ar);
+
+    if (new_capacity < needed)
+        new_capacity = needed;
+
+    enum cc_stat status = resize_buffer(ar, new_capacity);
+
+    if (status == CC_OK && ar->growth == CC_ARRAY_GROWTH_SIZE_CLASS)
+        claim_slack(ar);
+
+    return status;
+}
+
+/**
+ * Rounds the number of bytes up to a multiple of align, or returns 0 if
+ * that would overflow.
+ */
+static size_t round_up(size_t bytes, size_t align)
+{
+    if (bytes > CC_MAX_ELEMENTS - align)
+        return 0;
+
+    return (bytes + align - 1) / align * align;
+}
+
+/**
+ * Computes the expanded capacity of the CC_Array according to its growth
+ * strategy. Overflows are reported by returning a capacity that is not larger
+ * than the current one.
+ *
+ * @param[in] ar array whose expanded capacity is being computed
+ *
+ * @return the expanded capacity.
+ */
+static size_t grow_capacity(CC_Array const *ar)
+{
+    size_t cap = ar->capacity;
+
+    switch (ar->growth) {
+    case CC_ARRAY_GROWTH_DOUBLE:
+        return cap > CC_MAX_ELEMENTS / 2 ? 0 : cap * 2;
+
+    case CC_ARRAY_GROWTH_HALF:
+        /* Small capacities grow by at least one slot */
+        if (cap > CC_MAX_ELEMENTS - cap / 2 - 1)
+            return 0;
+        return cap + (cap < 2 ? 1 : cap / 2);
+
+    case CC_ARRAY_GROWTH_ADDITIVE:
+        if (cap < GROWTH_ADDITIVE_LIMIT)
+            return cap + GROWTH_ADDITIVE_STEP;
+        return cap > CC_MAX_ELEMENTS / 2 ? 0 : cap * 2;
+
+    case CC_ARRAY_GROWTH_SIZE_CLASS: {
+        if (cap > CC_MAX_ELEMENTS / 2 / sizeof(void*))
+            return 0;
+
+        size_t bytes = cap * 2 * sizeof(void*);
+        size_t align = bytes < GROWTH_SIZE_CLASS_PAGE ?
+            GROWTH_SIZE_CLASS_ALIGN : GROWTH_SIZE_CLASS_PAGE;
+
+        return round_up(bytes, align) / sizeof(void*);
+    }
+    case CC_ARRAY_GROWTH_FACTOR:
+    default:
+        return cap * ar->exp_factor;
+    }
+}
+
+/**
+ * Raises the capacity of the CC_Array to cover the whole block backing its
+ * buffer, so that the slack the allocator rounded the request up to is put to
+ * use. This is only done where the size of the block is known, which is for
+ * mapped buffers and, with glibc, for buffers allocated through malloc.
+ *
+ * @param[in] ar array whose capacity is being adjusted
+ */
+static void claim_slack(CC_Array *ar)
+{
+    if (array_is_inline(ar))
+        return;
+
+#ifdef CC_ARRAY_MMAP
+    if (ar->mapped) {
+        ar->capacity = ar->mapped / sizeof(void*);
+        return;
+    }
+#endif /* CC_ARRAY_MMAP */
+
+#ifdef CC_ARRAY_USABLE_SIZE
+    if (!ar->allocator && ar->mem_alloc == malloc
+        && (!ar->mem_realloc || ar->mem_realloc == realloc))
+        ar->capacity = malloc_usable_size(ar->buffer) / sizeof(void*);
+#endif /* CC_ARRAY_USABLE_SIZE */
+}
+
+/**
+ * Resizes the CC_Array buffer so that it can hold exactly new_capacity
+ * elements. The buffer is resized in place through the reallocator if the
+ * array has one, otherwise a new buffer is allocated and the elements are
+ * copied over. Capacities that fit in the inline slots move the elements
+ * back into them, in which case the capacity becomes the inline capacity.
+ * The array is left untouched if the allocation fails or if a fixed capacity
+ * array would have to grow.
+ *
+ * @param[in] ar array whose buffer is being resized
+ * @param[in] new_capacity the new capacity, which must not be smaller than
+ *                         the array size
+ *
+ * @return CC_OK if the buffer was resized successfully, CC_ERR_ALLOC if
+ * the memory allocation for the new buffer failed, or CC_ERR_MAX_CAPACITY
+ * if the array has a fixed capacity that is smaller than new_capacity.
+ */
+static enum cc_stat resize_buffer(CC_Array *ar, size_t new_capacity)
+{
+    void **new_buff;
+
+    if (ar->fixed && new_capacity > ar->inline_capacity)
+        return CC_ERR_MAX_CAPACITY;
+
+    if (ar->refs) {
+        /* A shared buffer is copied straight into one of the new size */
+        bool shared = *ar->refs > 1;
+        enum cc_stat status = buffer_unshare(ar, new_capacity);
+
+        if (status != CC_OK || shared)
+            return status;
+    }
+
+    if (new_capacity > CC_MAX_ELEMENTS / sizeof(void*))
+        return CC_ERR_ALLOC;
+
+    size_t bytes = new_capacity * sizeof(void*);
+
+    if (new_capacity <= ar->inline_capacity) {
+        if (!array_is_inline(ar)) {
+            memcpy(ar->inline_buf, ar->buffer, ar->size * sizeof(void*));
+            buffer_free(ar);
+            ar->buffer = ar->inline_buf;
+        }
+        ar->capacity = ar->inline_capacity;
+        return CC_OK;
+    }
+    if (array_is_inline(ar)) {
+        /* Spill the inline slots to the heap */
+        if (!(new_buff = buffer_alloc(ar, new_capacity)))
+            return CC_ERR_ALLOC;
+
+        memcpy(new_buff, ar->buffer, ar->size * sizeof(void*));
+
+        ar->buffer   = new_buff;
+        ar->capacity = new_capacity;
+        return CC_OK;
+    }
+
+#ifdef CC_ARRAY_MMAP
+    if (ar->mapped) {
+        /* Let the kernel move the pages instead of copying them */
+        size_t len = page_round(bytes);
+
+        if (!len)
+            return CC_ERR_ALLOC;
+
+        if (len != ar->mapped) {
+            new_buff = mremap(ar->buffer, ar->mapped, len, MREMAP_MAYMOVE);
+
+            if (new_buff == MAP_FAILED)
+                return CC_ERR_ALLOC;
+
+            ar->buffer = new_buff;
+            ar->mapped = len;
+        }
+        ar->capacity = new_capacity;
+        return CC_OK;
+    }
+    if (ar->mmap_threshold && bytes >= ar->mmap_threshold) {
+        void **old_buff = ar->buffer;
+
+        if (!(new_buff = buffer_alloc(ar, new_capacity)))
+            return CC_ERR_ALLOC;
+
+        memcpy(new_buff, old_buff, ar->size * sizeof(void*));
+        array_free(ar, old_buff);
+
+        ar->buffer   = new_buff;
+        ar->capacity = new_capacity;
+        return CC_OK;
+    }
+#endif /* CC_ARRAY_MMAP */
+
+    if (ar->allocator && ar->allocator->mem_realloc) {
+        new_buff = ar->allocator->mem_realloc(ar->allocator->ctx, ar->buffer, bytes);
+    } else if (!ar->allocator && ar->mem_realloc) {
+        new_buff = ar->mem_realloc(ar->buffer, bytes);
+    } else {
+        new_buff = array_alloc(ar, bytes);
+
+        if (new_buff) {
+            memcpy(new_buff, ar->buffer, ar->size * sizeof(void*));
+            array_free(ar, ar->buffer);
+        }
+    }
+
+    if (!new_buff)
+        return CC_ERR_ALLOC;
+
+    ar->buffer   = new_buff;
+    ar->capacity = new_capacity;
+
+    return CC_OK;
+}
+
+/**
+ * Shrinks the buffer of an auto_shrink CC_Array. The capacity is halved for
+ * as long as the array is at most a quarter full and the capacity stays at
+ * or above the initial capacity, so that an array hovering around a given
+ * size does not keep shrinking and expanding. Shrinking is best effort and
+ * the array is left as is if the resize fails.
+ *
+ * @param[in] ar array whose capacity is being shrunk
+ */
+static void shrink_capacity(CC_Array *ar)
+{
+    if (!ar->auto_shrink)
+        return;
+
+    size_t new_capacity = ar->capacity;
+
+    while (ar->size <= new_capacity / 4 && new_capacity / 2 >= ar->min_capacity)
+        new_capacity /= 2;
+
+    if (new_capacity < ar->capacity)
+        resize_buffer(ar, new_capacity);
+}
+
+#ifdef CC_ARRAY_MMAP
+/**
+ * Rounds the number of bytes up to a multiple of the page size.
+ *
+ * @return the rounded size, or 0 if it would overflow.
+ */
+static size_t page_round(size_t bytes)
+{
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+
+    if (bytes > CC_MAX_ELEMENTS - page)
+        return 0;
+
+    return (bytes + page - 1) / page * page;
+}
+#endif /* CC_ARRAY_MMAP */
+
+/**
+ * Allocates a data buffer for capacity elements for a CC_Array that does not
+ * yet own a buffer. Capacities that fit in the array's inline slots use them
+ * instead. Buffers that reach the array's mmap threshold are mapped directly,
+ * in which case the length of the mapping is recorded in the array.
+ *
+ * @param[in] ar array for which the buffer is being allocated
+ * @param[in] capacity number of elements the buffer must hold
+ *
+ * @return the new buffer, or NULL if the allocation failed.
+ */
+static void **buffer_alloc(CC_Array *ar, size_t capacity)
+{
+    if (capacity > CC_MAX_ELEMENTS / sizeof(void*))
+        return NULL;
+
+    size_t bytes = capacity * sizeof(void*);
+
+    ar->mapped = 0;
+
+    if (capacity <= ar->inline_capacity)
+        return ar->inline_buf;
+
+#ifdef CC_ARRAY_MMAP
+    if (ar->mmap_threshold && bytes >= ar->mmap_threshold) {
+        size_t len = page_round(bytes);
+
+        if (!len)
+            return NULL;
+
+        void *mem = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (mem == MAP_FAILED)
+            return NULL;
+
+        ar->mapped = len;
+        return mem;
+    }
+#endif /* CC_ARRAY_MMAP */
+
+    return array_alloc(ar, bytes);
+}
+
+/**
+ * Releases the data buffer of a CC_Array.
+ *
+ * @param[in] ar array whose buffer is being released
+ */
+static void buffer_free(CC_Array *ar)
+{
+    if (array_is_inline(ar))
+        return;
+
+    if (ar->refs) {
+        /* Only the last array sharing the buffer releases it */
+        if (--*ar->refs > 0) {
+            ar->refs = NULL;
+            return;
+        }
+        array_free(ar, ar->refs);
+        ar->refs = NULL;
+    }
+
+#ifdef CC_ARRAY_MMAP
+    if (ar->mapped) {
+        munmap(ar->buffer, ar->mapped);
+        ar->mapped = 0;
+        return;
+    }
+#endif /* CC_ARRAY_MMAP */
+
+    array_free(ar, ar->buffer);
+}
+
+/**
+ * Gives the CC_Array a buffer of its own in place of one that is shared with
+ * copy-on-write copies. If the other copies are already gone the buffer is
+ * simply taken over, otherwise the elements are copied into a new buffer of
+ * the specified capacity. The array is left untouched if the allocation
+ * fails.
+ *
+ * @param[in] ar array whose buffer is being unshared
+ * @param[in] capacity capacity of the new buffer, which must not be smaller
+ *                     than the array size
+ *
+ * @return CC_OK if the array owns its buffer, or CC_ERR_ALLOC if the memory
+ * allocation for the new buffer failed.
+ */
+static enum cc_stat buffer_unshare(CC_Array *ar, size_t capacity)
+{
+    if (*ar->refs == 1) {
+        array_free(ar, ar->refs);
+        ar->refs = NULL;
+        return CC_OK;
+    }
+
+    void **old_buff   = ar->buffer;
+    size_t old_mapped = ar->mapped;
+    void **new_buff   = buffer_alloc(ar, capacity);
+
+    if (!new_buff) {
+        ar->mapped = old_mapped;
+        return CC_ERR_ALLOC;
+    }
+    memcpy(new_buff, old_buff, ar->size * sizeof(void*));
+
+    (*ar->refs)--;
+    ar->refs     = NULL;
+    ar->buffer   = new_buff;
+    ar->capacity = array_is_inline(ar) ? ar->inline_capacity : capacity;
+
+    return CC_OK;
+}
+
+/**
+ * Hashes a pointer into a slot of an index table with the specified mask.
+ */
+static INLINE size_t index_slot(void const *key, size_t mask)
+{
+    /* Fibonacci hashing of the pointer without its alignment bits */
+    uint64_t h = ((uint64_t) (uintptr_t) key >> 3) * UINT64_C(0x9E3779B97F4A7C15);
+    return (size_t) (h >> 32) & mask;
+}
+
+/**
+ * Looks up the entry of the key in the index.
+ *
+ * @return the entry of the key, or NULL if the key is not in the index.
+ */
+static ArrayIndexEntry *index_find(ArrayIndex const *ix, void const *key)
+{
+    size_t mask = ix->capacity - 1;
+    size_t i    = index_slot(key, mask);
+
+    while (ix->table[i].count) {
+        if (ix->table[i].key == key)
+            return &(ix->table[i]);
+        i = (i + 1) & mask;
+    }
+    return NULL;
+}
+
+/**
+ * Places a new entry into the first free slot of its probe sequence.
+ */
+static void index_place(ArrayIndex *ix, ArrayIndexEntry const *entry)
+{
+    size_t mask = ix->capacity - 1;
+    size_t i    = index_slot(entry->key, mask);
+
+    while (ix->table[i].count)
+        i = (i + 1) & mask;
+
+    ix->table[i] = *entry;
+}
+
+/**
+ * Rehashes the index into a table of the specified capacity, which must be a
+ * power of two that leaves room for all the entries.
+ *
+ * @return true if the table was replaced, or false if the allocation failed.
+ */
+static bool index_resize(CC_Array *ar, size_t capacity)
+{
+    ArrayIndex      *ix    = ar->index;
+    ArrayIndexEntry *table = array_calloc(ar, capacity, sizeof(ArrayIndexEntry));
+
+    if (!table)
+        return false;
+
+    ArrayIndexEntry *old_table    = ix->table;
+    size_t           old_capacity = ix->capacity;
+
+    ix->table    = table;
+    ix->capacity = capacity;
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_table[i].count)
+            index_place(ix, &old_table[i]);
+    }
+    array_free(ar, old_table);
+
+    return true;
+}
+
+/**
+ * Records that the key was added at position pos. The index is marked as
+ * stale if its table cannot be grown.
+ */
+static void index_add(CC_Array *ar, void *key, size_t pos)
+{
+    ArrayIndex *ix = ar->index;
+
+    ArrayIndexEntry *e = index_find(ix, key);
+
+    if (e) {
+        e->count++;
+        if (pos < e->first)
+            e->first = pos;
+        return;
+    }
+
+    /* Keep the load factor at or below one half */
+    if ((ix->entries + 1) * 2 > ix->capacity &&
+        (ix->capacity > CC_MAX_ELEMENTS / 2 / sizeof(ArrayIndexEntry) ||
+         !index_resize(ar, ix->capacity * 2))) {
+        ix->dirty = true;
+        return;
+    }
+
+    ArrayIndexEntry entry = { key, pos, 1 };
+    index_place(ix, &entry);
+    ix->entries++;
+}
+
+/**
+ * Removes an entry from the index by shifting the following entries of the
+ * probe sequence back, so that lookups never need tombstones.
+ */
+static void index_delete(ArrayIndex *ix, ArrayIndexEntry *e)
+{
+    size_t mask = ix->capacity - 1;
+    size_t hole = (size_t) (e - ix->table);
+    size_t i    = hole;
+
+    for (;;) {
+        i = (i + 1) & mask;
+
+        if (!ix->table[i].count)
+            break;
+
+        /* An entry may only move back if its home slot does not lie
+         * cyclically between the hole and its current slot */
+        size_t home = index_slot(ix->table[i].key, mask);
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            ix->table[hole] = ix->table[i];
+            hole = i;
+        }
+    }
+    ix->table[hole].count = 0;
+    ix->entries--;
+}
+
+/**
+ * Rebuilds a stale index from the contents of the array.
+ *
+ * @return true if the index is up to date, or false if the allocation of the
+ * table failed.
+ */
+static bool index_rebuild(CC_Array *ar)
+{
+    ArrayIndex *ix = ar->index;
+
+    size_t capacity = INDEX_MIN_CAPACITY;
+    while (capacity < ar->size * 2 && capacity <= CC_MAX_ELEMENTS / 4 / sizeof(ArrayIndexEntry))
+        capacity *= 2;
+
+    if (capacity != ix->capacity) {
+        ArrayIndexEntry *table = array_calloc(ar, capacity, sizeof(ArrayIndexEntry));
+
+        if (!table)
+            return false;
+
+        if (ix->table)
+            array_free(ar, ix->table);
+        ix->table    = table;
+        ix->capacity = capacity;
+    } else {
+        memset(ix->table, 0, capacity * sizeof(ArrayIndexEntry));
+    }
+    ix->entries = 0;
+    ix->dirty   = false;
+
+    for (size_t i = 0; i < ar->size; i++) {
+        index_add(ar, ar->buffer[i], i);
+        if (ix->dirty)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Returns true if the array has an up to date index, rebuilding it first if it
+ * is stale. Callers fall back to a linear scan if it returns false.
+ */
+static bool index_ready(CC_Array *ar)
+{
+    if (!ar->index)
+        return false;
+
+    return !ar->index->dirty || index_rebuild(ar);
+}
+
+/**
+ * Records that the element at the end of the array was appended.
+ */
+static INLINE void index_appended(CC_Array *ar)
+{
+    if (ar->index && !ar->index->dirty)
+        index_add(ar, ar->buffer[ar->size - 1], ar->size - 1);
+}
+
+/**
+ * Records that the elements from position from to the end of the array were
+ * appended.
+ */
+static void index_appended_from(CC_Array *ar, size_t from)
+{
+    for (size_t i = from; i < ar->size && ar->index && !ar->index->dirty; i++)
+        index_add(ar, ar->buffer[i], i);
+}
+
+/**
+ * Records that the key is about to be removed from position pos. Must be
+ * called while the array still holds the key at pos, since the next
+ * occurrence of the key becomes its first one if pos was the first.
+ */
+static void index_removed(CC_Array *ar, void *key, size_t pos)
+{
+    ArrayIndex *ix = ar->index;
+
+    if (!ix || ix->dirty)
+        return;
+
+    ArrayIndexEntry *e = index_find(ix, key);
+
+    if (!e) {
+        ix->dirty = true;
+        return;
+    }
+    if (--e->count == 0) {
+        index_delete(ix, e);
+    } else if (e->first == pos) {
+        size_t i = pos + 1;
+        while (i < ar->size && ar->buffer[i] != key)
+            i++;
+        e->first = i;
+    }
+}
+
+/**
+ * Records that an occurrence of the key was moved from position from to
+ * position to, where the array now holds it.
+ */
+static void index_moved(CC_Array *ar, void *key, size_t from, size_t to)
+{
+    ArrayIndex *ix = ar->index;
+
+    if (!ix || ix->dirty)
+        return;
+
+    ArrayIndexEntry *e = index_find(ix, key);
+
+    if (!e) {
+        ix->dirty = true;
+    } else if (to < e->first || e->count == 1) {
+        e->first = to;
+    } else if (e->first == from) {
+        /* The first occurrence moved forward, past any others in between */
+        size_t i = from + 1;
+        while (i < to && ar->buffer[i] != key)
+            i++;
+        e->first = i;
+    }
+}
+
+/**
+ * Records that n slots were opened at position pos, shifting the elements
+ * from pos onwards n positions towards the end of the array.
+ */
+static void index_opened(CC_Array *ar, size_t pos, size_t n)
+{
+    ArrayIndex *ix = ar->index;
+
+    if (!ix || ix->dirty)
+        return;
+
+    for (size_t i = 0; i < ix->capacity; i++) {
+        if (ix->table[i].count && ix->table[i].first >= pos)
+            ix->table[i].first += n;
+    }
+}
+
+/**
+ * Records that the n slots at position pos were closed, shifting the
+ * elements after them n positions towards the beginning of the array. The
+ * removed elements must have been recorded with <code>index_removed()</code>.
+ */
+static void index_closed(CC_Array *ar, size_t pos, size_t n)
+{
+    ArrayIndex *ix = ar->index;
+
+    if (!ix || ix->dirty)
+        return;
+
+    for (size_t i = 0; i < ix->capacity; i++) {
+        if (ix->table[i].count && ix->table[i].first >= pos + n)
+            ix->table[i].first -= n;
+    }
+}
+
+/**
+ * Marks the index as stale after the positions of the elements changed in a
+ * way that is not tracked incrementally.
+ */
+static INLINE void index_invalidate(CC_Array *ar)
+{
+    if (ar->index)
+        ar->index->dirty = true;
+}
+
+/**
+ * Empties the index after all elements were removed.
+ */
+static void index_clear(CC_Array *ar)
+{
+    ArrayIndex *ix = ar->index;
+
+    if (!ix)
+        return;
+
+    memset(ix->table, 0, ix->capacity * sizeof(ArrayIndexEntry));
+    ix->entries = 0;
+    ix->dirty   = false;
+}
+
+/**
+ * Adds a hash index to the CC_Array that maps each element to the index of its
+ * first occurrence and its number of occurrences. While the index is enabled,
+ * <code>cc_array_contains()</code>, <code>cc_array_index_of()</code> and the
+ * functions that remove an element by its value run in constant average time.
+ * Adding, removing, replacing and swapping single elements, and inserting
+ * ranges, keep the index up to date in place, while operations that move
+ * many elements around at once, such as sorting or filtering, mark it as
+ * stale, in which case it is rebuilt by the next lookup. If the index cannot
+ * be maintained due to an allocation failure, lookups fall back to a linear
+ * scan.
+ *
+ * @note The index is not copied to arrays derived from this one.
+ *
+ * @param[in] ar the array that is being indexed
+ *
+ * @return CC_OK if the index was enabled, or CC_ERR_ALLOC if the memory
+ * allocation for the index failed.
+ */
+enum cc_stat cc_array_index_enable(CC_Array *ar)
+{
+    if (ar->index)
+        return CC_OK;
+
+    ArrayIndex *ix = array_calloc(ar, 1, sizeof(ArrayIndex));
+
+    if (!ix)
+        return CC_ERR_ALLOC;
+
+    ix->dirty = true;
+    ar->index = ix;
+
+    if (!index_rebuild(ar)) {
+        cc_array_index_disable(ar);
+        return CC_ERR_ALLOC;
+    }
+    return CC_OK;
+}
+
+/**
+ * Removes the hash index from the CC_Array, if it has one.
+ *
+ * @param[in] ar the array whose index is being removed
+ */
+void cc_array_index_disable(CC_Array *ar)
+{
+    if (!ar->index)
+        return;
+
+    if (ar->index->table)
+        array_free(ar, ar->index->table);
+    array_free(ar, ar->index);
+    ar->index = NULL;
+}
+
+/**
+ * Copies the configuration (expansion factor and allocators) of an array
+ * onto a newly created array derived from it.
+ *
+ * @param[in] ar array whose configuration is being copied
+ * @param[in] copy array that inherits the configuration
+ */
+static void array_inherit_conf(CC_Array const *ar, CC_Array *copy)
+{
+    copy->exp_factor      = ar->exp_factor;
+    copy->mem_alloc       = ar->mem_alloc;
+    copy->mem_calloc      = ar->mem_calloc;
+    copy->mem_free        = ar->mem_free;
+    copy->mem_realloc     = ar->mem_realloc;
+    copy->allocator       = ar->allocator;
+    copy->mmap_threshold  = ar->mmap_threshold;
+    copy->inline_capacity = ar->inline_capacity;
+    copy->fixed           = ar->fixed;
+    copy->auto_shrink     = ar->auto_shrink;
+    copy->min_capacity    = ar->min_capacity;
+    copy->growth          = ar->growth;
+}
+
+/**
+ * Applies the function fn to each element of the CC_Array.
+ *
+ * @param[in] ar array on which this operation is performed
+ * @param[in] fn operation function that is to be invoked on each CC_Array
+ *               element
+ */
+void cc_array_map(CC_Array *ar, void (*fn) (void *e))
+{
+    size_t i;
+    for (i = 0; i < ar->size; i++)
+        fn(ar->buffer[i]);
+}
+
+/**
+ * A fold/reduce function that collects all of the elements in the array
+ * together. For example, if we have an array of [a,b,c...] the end result
+ * will be (...((a+b)+c)+...).
+ *
+ * @param[in] ar the array on which this operation is performed
+ * @param[in] fn the operation function that is to be invoked on each array
+ *               element
+ * @param[in] result the pointer which will collect the end result
+ */
+void cc_array_reduce(CC_Array *ar, void (*fn) (void*, void*, void*), void *result)
+{
+    if (ar->size == 1) {
+        fn(ar->buffer[0], NULL, result);
+        return;
+    }
+    if (ar->size > 1)
+        fn(ar->buffer[0], ar->buffer[1], result);
+
+    for (size_t i = 2; i < ar->size; i++)
+        fn(result, ar->buffer[i], result);
+}
+
+/**
+ * Initializes the iterator.
+ *
+ * @param[in] iter the iterator that is being initialized
+ * @param[in] ar the array to iterate over
+ */
+void cc_array_iter_init(CC_ArrayIter *iter, CC_Array *ar)
+{
+    iter->ar    = ar;
+    iter->index = 0;
+    iter->last_removed = false;
+}
+
+/**
+ * Advances the iterator and sets the out parameter to the value of the
+ * next element in the sequence.
+ *
+ * @param[in] iter the iterator that is being advanced
+ * @param[out] out pointer to where the next element is set
+ *
+ * @return CC_OK if the iterator was advanced, or CC_ITER_END if the
+ * end of the CC_Array has been reached.
+ */
+enum cc_stat cc_array_iter_next(CC_ArrayIter *iter, void **out)
+{
+    if (iter->index >= iter->ar->size)
+        return CC_ITER_END;
+
+    *out = iter->ar->buffer[iter->index];
+
+    iter->index++;
+    iter->last_removed = false;
+
+    return CC_OK;
+}
+
+/**
+ * Removes the last returned element by <code>cc_array_iter_next()</code>
+ * function without invalidating the iterator and optionally sets the out
+ * parameter to the value of the removed element.
+ *
+ * @note This function should only ever be called after a call to <code>
+ * cc_array_iter_next()</code>.
+
+ * @param[in] iter the iterator on which this operation is being performed
+ * @param[out] out pointer to where the removed element is stored, or NULL
+ *                 if it is to be ignored
+ *
+ * @return CC_OK if the element was successfully removed, or
+ * CC_ERR_VALUE_NOT_FOUND.
+ */
+enum cc_stat cc_array_iter_remove(CC_ArrayIter *iter, void **out)
+{
+    enum cc_stat status = CC_ERR_VALUE_NOT_FOUND;
+
+    if (!iter->last_removed) {
+        status = cc_array_remove_at(iter->ar, iter->index - 1, out);
+        if (status == CC_OK)
+            iter->last_removed = true;
+    }
+    return status;
+}
+
+/**
+ * Removes the last returned element by <code>cc_array_iter_next()</code>
+ * without preserving the order of the remaining elements and optionally sets
+ * the out parameter to the value of the removed element. The last element of
+ * the array takes the place of the removed one and is returned by the next
+ * call to <code>cc_array_iter_next()</code>, so that no element is skipped.
+ *
+ * @note This function should only ever be called after a call to <code>
+ * cc_array_iter_next()</code>.
+ *
+ * @param[in] iter the iterator on which this operation is being performed
+ * @param[out] out pointer to where the removed element is stored, or NULL
+ *                 if it is to be ignored
+ *
+ * @return CC_OK if the element was successfully removed, or
+ * CC_ERR_VALUE_NOT_FOUND.
+ */
+enum cc_stat cc_array_iter_remove_unordered(CC_ArrayIter *iter, void **out)
+{
+    enum cc_stat status = CC_ERR_VALUE_NOT_FOUND;
+
+    if (!iter->last_removed) {
+        status = cc_array_remove_at_unordered(iter->ar, iter->index - 1, out);
+        if (status == CC_OK) {
+            iter->index--;
+            iter->last_removed = true;
+        }
+    }
+    return status;
+}
+
+/**
+ * Adds a new element to the CC_Array after the last returned element by
+ * <code>cc_array_iter_next()</code> function without invalidating the
+ * iterator.
+ *
+ * @note This function should only ever be called after a call to <code>
+ * cc_array_iter_next()</code>.
+ *
+ * @param[in] iter the iterator on which this operation is being performed
+ * @param[in] element the element being added
+ *
+ * @return CC_OK if the element was successfully added, CC_ERR_ALLOC if the
+ * memory allocation for the new element failed, or CC_ERR_MAX_CAPACITY if
+ * the array is already at maximum capacity.
+ */
+enum cc_stat cc_array_iter_add(CC_ArrayIter *iter, void *element)
+{
+    return cc_array_add_at(iter->ar, element, iter->index++);
+}
+
+/**
+ * Replaces the last returned element by <code>cc_array_iter_next()</code>
+ * with the specified element and optionally sets the out parameter to
+ * the value of the replaced element.
+ *
+ * @note This function should only ever be called after a call to <code>
+ * cc_array_iter_next()</code>.
+ *
+ * @param[in] iter the iterator on which this operation is being performed
+ * @param[in] element the replacement element
+ * @param[out] out pointer to where the replaced element is stored, or NULL
+ *                if it is to be ignored
+ *
+ * @return CC_OK if the element was replaced successfully, or
+ * CC_ERR_OUT_OF_RANGE.
+ */
+enum cc_stat cc_array_iter_replace(CC_ArrayIter *iter, void *element, void **out)
+{
+    return cc_array_replace_at(iter->ar, element, iter->index - 1, out);
+}
+
+/**
+ * Returns the index of the last returned element by <code>cc_array_iter_next()
+ * </code>.
+ *
+ * @note
+ * This function should not be called before a call to <code>cc_array_iter_next()
+ * </code>.
+ *
+ * @param[in] iter the iterator on which this operation is being performed
+ *
+ * @return the index.
+ */
+size_t cc_array_iter_index(CC_ArrayIter *iter)
+{
+    return iter->index - 1;
+}
+
+/**
+ * Initializes the zip iterator.
+ *
+ * @param[in] iter iterator that is being initialized
+ * @param[in] ar1  first array
+ * @param[in] ar2  second array
+ */
+void cc_array_zip_iter_init(CC_ArrayZipIter *iter, CC_Array *ar1, CC_Array *ar2)
+{
+    iter->ar1 = ar1;
+    iter->ar2 = ar2;
+    iter->index = 0;
+    iter->last_removed = false;
+}
+
+/**
+ * Outputs the next element pair in the sequence and advances the iterator.
+ *
+ * @param[in]  iter iterator that is being advanced
+ * @param[out] out1 output of the first array element
+ * @param[out] out2 output of the second array element
+ *
+ * @return CC_OK if a next element pair is returned, or CC_ITER_END if the end of one
+ * of the arrays has been reached.
+ */
+enum cc_stat cc_array_zip_iter_next(CC_ArrayZipIter *iter, void **out1, void **out2)
+{
+    if (iter->index >= iter->ar1->size || iter->index >= iter->ar2->size)
+        return CC_ITER_END;
+
+    *out1 = iter->ar1->buffer[iter->index];
+    *out2 = iter->ar2->buffer[iter->index];
+
+    iter->index++;
+    iter->last_removed = false;
+
+    return CC_OK;
+}
+
+/**
+ * Removes and outputs the last returned element pair by <code>cc_array_zip_iter_next()
+ * </code> without invalidating the iterator.
+ *
+ * @param[in]  iter iterator on which this operation is being performed
+ * @param[out] out1 output of the removed element from the first array
+ * @param[out] out2 output of the removed element from the second array
+ *
+ * @return CC_OK if the element was successfully removed, CC_ERR_OUT_OF_RANGE if the
+ * state of the iterator is invalid, or CC_ERR_VALUE_NOT_FOUND if the element was
+ * already removed.
+ */
+enum cc_stat cc_array_zip_iter_remove(CC_ArrayZipIter *iter, void **out1, void **out2)
+{
+    if ((iter->index - 1) >= iter->ar1->size || (iter->index - 1) >= iter->ar2->size)
+        return CC_ERR_OUT_OF_RANGE;
+
+    if (!iter->last_removed) {
+        cc_array_remove_at(iter->ar1, iter->index - 1, out1);
+        cc_array_remove_at(iter->ar2, iter->index - 1, out2);
+        iter->last_removed = true;
+        return CC_OK;
+    }
+    return CC_ERR_VALUE_NOT_FOUND;
+}
+
+/**
+ * Adds a new element pair to the arrays after the last returned element pair by
+ * <code>cc_array_zip_iter_next()</code> and immediately before an element pair
+ * that would be returned by a subsequent call to <code>cc_array_zip_iter_next()</code>
+ * without invalidating the iterator.
+ *
+ * @param[in] iter iterator on which this operation is being performed
+ * @param[in] e1   element added to the first array
+ * @param[in] e2   element added to the second array
+ *
+ * @return CC_OK if the element pair was successfully added to the arrays, or
+ * CC_ERR_ALLOC if the memory allocation for the new elements failed.
+ */
+enum cc_stat cc_array_zip_iter_add(CC_ArrayZipIter *iter, void *e1, void *e2)
+{
+    size_t index = iter->index++;
+    CC_Array  *ar1  = iter->ar1;
+    CC_Array  *ar2  = iter->ar2;
+
+    /* Make sure both array buffers have room */
+    if ((ar1->size == ar1->capacity && (expand_capacity(ar1) != CC_OK)) ||
+            (ar2->size == ar2->capacity && (expand_capacity(ar2) != CC_OK)))
+        return CC_ERR_ALLOC;
+
+    cc_array_add_at(ar1, e1, index);
+    cc_array_add_at(ar2, e2, index);
+
+    return CC_OK;
+}
+
+/**
+ * Adds n element pairs from the src1 and src2 buffers to the arrays after the
+ * last returned element pair by <code>cc_array_zip_iter_next()</code> without
+ * invalidating the iterator. The iterator moves past the added pairs, so that
+ * a subsequent call to <code>cc_array_zip_iter_next()</code> returns the pair
+ * that followed them.
+ *
+ * @param[in] iter iterator on which this operation is being performed
+ * @param[in] src1 elements added to the first array
+ * @param[in] src2 elements added to the second array
+ * @param[in] n    number of elements in each of the buffers
+ *
+ * @return CC_OK if the element pairs were successfully added to the arrays,
+ * CC_ERR_OUT_OF_RANGE if the iterator position is past the end of one of the
+ * arrays, CC_ERR_ALLOC if the memory allocation for the new elements failed,
+ * or CC_ERR_MAX_CAPACITY if one of the arrays cannot hold the new elements.
+ * Nothing is added and the iterator is left unchanged on failure.
+ */
+enum cc_stat cc_array_zip_iter_add_range(CC_ArrayZipIter *iter, void * const *src1, void * const *src2, size_t n)
+{
+    CC_Array *ar1 = iter->ar1;
+    CC_Array *ar2 = iter->ar2;
+
+    /* The position may be past the end after the last pair was removed */
+    if (iter->index > ar1->size || iter->index > ar2->size)
+        return CC_ERR_OUT_OF_RANGE;
+
+    /* Make sure both array buffers have room before touching either */
+    enum cc_stat status = ensure_capacity(ar1, n);
+    if (status != CC_OK)
+        return status;
+
+    status = ensure_capacity(ar2, n);
+    if (status != CC_OK)
+        return status;
+
+    status = cc_array_add_range_at(ar1, src1, n, iter->index);
+    if (status != CC_OK)
+        return status;
+
+    status = cc_array_add_range_at(ar2, src2, n, iter->index);
+    if (status != CC_OK) {
+        if (n > 0)
+            cc_array_remove_range(ar1, iter->index, iter->index + n - 1, NULL);
+        return status;
+    }
+
+    iter->index += n;
+
+    return CC_OK;
+}
+
+/**
+ * Replaces the last returned element pair by <code>cc_array_zip_iter_next()</code>
+ * with the specified replacement element pair.
+ *
+ * @param[in] iter  iterator on which this operation is being performed
+ * @param[in]  e1   first array's replacement element
+ * @param[in]  e2   second array's replacement element
+ * @param[out] out1 output of the replaced element from the first array
+ * @param[out] out2 output of the replaced element from the second array
+ *
+ * @return CC_OK if the element was successfully replaced, or CC_ERR_OUT_OF_RANGE.
+ */
+enum cc_stat cc_array_zip_iter_replace(CC_ArrayZipIter *iter, void *e1, void *e2, void **out1, void **out2)
+{
+    if ((iter->index - 1) >= iter->ar1->size || (iter->index - 1) >= iter->ar2->size)
+        return CC_ERR_OUT_OF_RANGE;
+
+    cc_array_replace_at(iter->ar1, e1, iter->index - 1, out1);
+    cc_array_replace_at(iter->ar2, e2, iter->index - 1, out2);
+
+    return CC_OK;
+}
+
+/**
+ * Returns the index of the last returned element pair by <code>cc_array_zip_iter_next()</code>.
+ *
+ * @param[in] iter iterator on which this operation is being performed
+ *
+ * @return current iterator index.
+ */
+size_t cc_array_zip_iter_index(CC_ArrayZipIter *iter)
+{
+    return iter->index - 1;
+}
+
+/**
+ * Initializes a slice that views the elements of the CC_Array in the specified
+ * index range without copying them.
+ *
+ * @param[in] ar the array whose elements are viewed
+ * @param[in] b the beginning index (inclusive) of the slice that must be
+ *              within the bounds of the array and must not exceed the end
+ *              index
+ * @param[in] e the end index (inclusive) of the slice that must be within the
+ *              bounds of the array and must be greater or equal to the
+ *              beginning index
+ * @param[out] out pointer to the slice that is being initialized
+ *
+ * @return CC_OK if the slice was successfully initialized, or
+ * CC_ERR_INVALID_RANGE if the specified index range is invalid.
+ */
+enum cc_stat cc_array_slice(CC_Array *ar, size_t b, size_t e, CC_ArraySlice *out)
+{
+    if (b > e || e >= ar->size)
+        return CC_ERR_INVALID_RANGE;
+
+    out->ar     = ar;
+    out->offset = b;
+    out->size   = e - b + 1;
+
+    return CC_OK;
+}
+
+/**
+ * Returns a pointer to the first element of the slice.
+ */
+static INLINE void **slice_base(CC_ArraySlice const *slice)
+{
+    return &(slice->ar->buffer[slice->offset]);
+}
+
+/**
+ * Gets the element at the specified index of the slice and sets the out
+ * parameter to its value. The index is relative to the start of the slice.
+ *
+ * @param[in] slice the slice from which the element is being retrieved
+ * @param[in] index the index of the element within the slice
+ * @param[out] out pointer to where the element is stored
+ *
+ * @return CC_OK if the element was found, or CC_ERR_OUT_OF_RANGE if the index
+ * was out of range.
+ */
+enum cc_stat cc_array_slice_get_at(CC_ArraySlice const *slice, size_t index, void **out)
+{
+    if (index >= slice->size)
+        return CC_ERR_OUT_OF_RANGE;
+
+    *out = slice_base(slice)[index];
+    return CC_OK;
+}
+
+/**
+ * Returns the number of elements in the slice.
+ *
+ * @param[in] slice the slice whose size is being returned
+ *
+ * @return the number of elements in the slice.
+ */
+size_t cc_array_slice_size(CC_ArraySlice const *slice)
+{
+    return slice->size;
+}
+
+/**
+ * Returns the number of occurrences of the element within the slice.
+ *
+ * @param[in] slice the slice that is being searched
+ * @param[in] element the element that is being searched for
+ *
+ * @return the number of occurrences of the element.
+ */
+size_t cc_array_slice_contains(CC_ArraySlice const *slice, void *element)
+{
+    void **buff = slice_base(slice);
+    size_t o = 0;
+    size_t i;
+    for (i = 0; i < slice->size; i++) {
+        if (buff[i] == element)
+            o++;
+    }
+    return o;
+}
+
+/**
+ * Returns the number of occurrences of the value pointed to by the element
+ * within the slice.
+ *
+ * @param[in] slice the slice that is being searched
+ * @param[in] element the element that is being searched for
+ * @param[in] cmp comparator function which returns 0 if the values passed to it are equal
+ *
+ * @return the number of occurrences of the value.
+ */
+size_t cc_array_slice_contains_value(CC_ArraySlice const *slice, void *element, int (*cmp) (const void*, const void*))
+{
+    void **buff = slice_base(slice);
+    size_t o = 0;
+    size_t i;
+    for (i = 0; i < slice->size; i++) {
+        if (cmp(element, buff[i]) == 0)
+            o++;
+    }
+    return o;
+}
+
+/**
+ * Sorts the elements of the slice in place, which reorders that range of the
+ * underlying CC_Array. The comparator follows the same convention as the one
+ * of <code>cc_array_sort()</code>.
+ *
+ * @param[in] slice the slice that is being sorted
+ * @param[in] cmp the comparator function
+ */
+void cc_array_slice_sort(CC_ArraySlice const *slice, int (*cmp) (const void*, const void*))
+{
+    if (array_own_buffer(slice->ar) != CC_OK)
+        return;
+
+    buffer_sort(slice_base(slice), slice->size, cmp);
+    index_invalidate(slice->ar);
+    slice->ar->sorted_cmp = NULL;
+}
+
+/**
+ * Applies the function fn to each element of the slice.
+ *
+ * @param[in] slice slice on which this operation is performed
+ * @param[in] fn operation function that is to be invoked on each element
+ */
+void cc_array_slice_map(CC_ArraySlice const *slice, void (*fn) (void *e))
+{
+    void **buff = slice_base(slice);
+    size_t i;
+    for (i = 0; i < slice->size; i++)
+        fn(buff[i]);
+}
+
+/**
+ * A fold/reduce function that collects all of the elements in the slice
+ * together, the same way <code>cc_array_reduce()</code> does for a whole
+ * array.
+ *
+ * @param[in] slice the slice on which this operation is performed
+ * @param[in] fn the operation function that is to be invoked on each element
+ * @param[in] result the pointer which will collect the end result
+ */
+void cc_array_slice_reduce(CC_ArraySlice const *slice, void (*fn) (void*, void*, void*), void *result)
+{
+    void **buff = slice_base(slice);
+
+    if (slice->size == 1) {
+        fn(buff[0], NULL, result);
+        return;
+    }
+    if (slice->size > 1)
+        fn(buff[0], buff[1], result);
+
+    for (size_t i = 2; i < slice->size; i++)
+        fn(result, buff[i], result);
+}
+
+/**
+ * Initializes the slice iterator.
+ *
+ * @param[in] iter the iterator that is being initialized
+ * @param[in] slice the slice to iterate over
+ */
+void cc_array_slice_iter_init(CC_ArraySliceIter *iter, CC_ArraySlice const *slice)
+{
+    iter->slice = slice;
+    iter->index = 0;
+}
+
+/**
+ * Advances the iterator and sets the out parameter to the value of the
+ * next element of the slice.
+ *
+ * @param[in] iter the iterator that is being advanced
+ * @param[out] out pointer to where the next element is set
+ *
+ * @return CC_OK if the iterator was advanced, or CC_ITER_END if the end of
+ * the slice has been reached.
+ */
+enum cc_stat cc_array_slice_iter_next(CC_ArraySliceIter *iter, void **out)
+{
+    if (iter->index >= iter->slice->size)
+        return CC_ITER_END;
+
+    *out = slice_base(iter->slice)[iter->index];
+    iter->index++;
+
+    return CC_OK;
+}
+
+struct cc_arrayv_s {
+    size_t          size;
+    size_t          capacity;
+    size_t          elem_size;
+    float           exp_factor;
+    unsigned char  *buffer;
+
+    void *(*mem_alloc)  (size_t size);
+    void *(*mem_calloc) (size_t blocks, size_t size);
+    void  (*mem_free)   (void *block);
+};
+
+static enum cc_stat arrayv_expand_capacity(CC_ArrayV *ar);
+
+/**
+ * Returns a pointer to the slot at the specified index.
+ */
+static INLINE unsigned char *arrayv_slot(CC_ArrayV *ar, size_t index)
+{
+    return ar->buffer + index * ar->elem_size;
+}
+
+/**
+ * Creates a new empty CC_ArrayV whose elements are <code>elem_size</code>
+ * bytes large and returns a status code.
+ *
+ * @param[in] elem_size size of a single element in bytes
+ * @param[out] out pointer to where the newly created CC_ArrayV is to be stored
+ *
+ * @return CC_OK if the creation was successful, CC_ERR_INVALID_CAPACITY if
+ * the element size is zero, or CC_ERR_ALLOC if the memory allocation for the
+ * new CC_ArrayV structure failed.
+ */
+enum cc_stat cc_arrayv_new(size_t elem_size, CC_ArrayV **out)
+{
+    CC_ArrayVConf c;
+    cc_arrayv_conf_init(&c, elem_size);
+    return cc_arrayv_new_conf(&c, out);
+}
+
+/**
+ * Creates a new empty CC_ArrayV based on the specified CC_ArrayVConf struct
+ * and returns a status code.
+ *
+ * The CC_ArrayV is allocated using the allocators specified in the
+ * CC_ArrayVConf struct. The allocation may fail if underlying allocator fails.
+ * It may also fail if the element size is zero or if the initial buffer or
+ * its first expansion would not be addressable.
+ *
+ * @param[in] conf array configuration structure
+ * @param[out] out pointer to where the newly created CC_ArrayV is to be stored
+ *
+ * @return CC_OK if the creation was successful, CC_ERR_INVALID_CAPACITY if
+ * the above mentioned conditions are not met, or CC_ERR_ALLOC if the memory
+ * allocation for the new CC_ArrayV structure failed.
+ */
+enum cc_stat cc_arrayv_new_conf(CC_ArrayVConf const * const conf, CC_ArrayV **out)
+{
+    float ex;
+
+    if (conf->exp_factor <= 1)
+        ex = DEFAULT_EXPANSION_FACTOR;
+    else
+        ex = conf->exp_factor;
+
+    if (!conf->elem_size || !conf->capacity)
+        return CC_ERR_INVALID_CAPACITY;
+
+    /* Same overflow guard as CC_Array, but in bytes since every slot
+     * is elem_size bytes wide. */
+    size_t max_elements = CC_MAX_ELEMENTS / conf->elem_size;
+
+    if (ex >= max_elements / conf->capacity)
+        return CC_ERR_INVALID_CAPACITY;
+
+    CC_ArrayV *ar = conf->mem_calloc(1, sizeof(CC_ArrayV));
+
+    if (!ar)
+        return CC_ERR_ALLOC;
+
+    unsigned char *buff = conf->mem_alloc(conf->capacity * conf->elem_size);
+
+    if (!buff) {
+        conf->mem_free(ar);
+        return CC_ERR_ALLOC;
+    }
+
+    ar->buffer     = buff;
+    ar->elem_size  = conf->elem_size;
+    ar->exp_factor = ex;
+    ar->capacity   = conf->capacity;
+    ar->mem_alloc  = conf->mem_alloc;
+    ar->mem_calloc = conf->mem_calloc;
+    ar->mem_free   = conf->mem_free;
+
+    *out = ar;
+    return CC_OK;
+}
+
+/**
+ * Initializes the fields of the CC_ArrayVConf struct to default values.
+ *
+ * @param[in, out] conf CC_ArrayVConf structure that is being initialized
+ * @param[in] elem_size size of a single element in bytes
+ */
+void cc_arrayv_conf_init(CC_ArrayVConf *conf, size_t elem_size)
+{
+    conf->elem_size  = elem_size;
+    conf->exp_factor = DEFAULT_EXPANSION_FACTOR;
+    conf->capacity   = DEFAULT_CAPACITY;
+    conf->mem_alloc  = malloc;
+    conf->mem_calloc = calloc;
+    conf->mem_free   = free;
+}
+
+/**
+ * Destroys the CC_ArrayV structure along with the element values it holds.
+ *
+ * @param[in] ar the array that is to be destroyed
+ */
+void cc_arrayv_destroy(CC_ArrayV *ar)
+{
+    ar->mem_free(ar->buffer);
+    ar->mem_free(ar);
+}
+
+/**
+ * Destroys the CC_ArrayV structure after invoking the callback on each of
+ * its elements. The callback receives a pointer to the element stored in
+ * the array, so it can release any resources the element refers to.
+ *
+ * @param[in] ar the array that is being destroyed
+ * @param[in] cb callback invoked on a pointer to each element
+ */
+void cc_arrayv_destroy_cb(CC_ArrayV *ar, void (*cb) (void*))
+{
+    size_t i;
+    for (i = 0; i < ar->size; i++)
+        cb(arrayv_slot(ar, i));
+
+    cc_arrayv_destroy(ar);
+}
+
+/**
+ * Copies a new element into the CC_ArrayV. The element is appended to the
+ * array making it the last element (the one with the highest index) of the
+ * CC_ArrayV.
+ *
+ * @param[in] ar the array to which the element is being added
+ * @param[in] element pointer to the <code>elem_size</code> bytes that are
+ *                    being copied into the array
+ *
+ * @return CC_OK if the element was successfully added, CC_ERR_ALLOC if the
+ * memory allocation for the new element failed, or CC_ERR_MAX_CAPACITY if the
+ * array is already at maximum capacity.
+ */
+enum cc_stat cc_arrayv_add(CC_ArrayV *ar, const void *element)
+{
+    if (ar->size >= ar->capacity) {
+        enum cc_stat status = arrayv_expand_capacity(ar);
+        if (status != CC_OK)
+            return status;
+    }
+
+    memcpy(arrayv_slot(ar, ar->size), element, ar->elem_size);
+    ar->size++;
+
+    return CC_OK;
+}
+
+/**
+ * Copies a new element into the array at a specified position by shifting
+ * all subsequent elements by one. The specified index must be within the
+ * bounds of the array.
+ *
+ * @param[in] ar the array to which the element is being added
+ * @param[in] element pointer to the value that is being copied into the array
+ * @param[in] index the position in the array at which the element is being
+ *            added
+ *
+ * @return CC_OK if the element was successfully added, CC_ERR_OUT_OF_RANGE if
+ * the specified index was not in range, CC_ERR_ALLOC if the memory
+ * allocation for the new element failed, or CC_ERR_MAX_CAPACITY if the
+ * array is already at maximum capacity.
+ */
+enum cc_stat cc_arrayv_add_at(CC_ArrayV *ar, const void *element, size_t index)
+{
+    if (index == ar->size)
+        return cc_arrayv_add(ar, element);
+
+    if (index > ar->size)
+        return CC_ERR_OUT_OF_RANGE;
+
+    if (ar->size >= ar->capacity) {
+        enum cc_stat status = arrayv_expand_capacity(ar);
+        if (status != CC_OK)
+            return status;
+    }
+
+    memmove(arrayv_slot(ar, index + 1),
+            arrayv_slot(ar, index),
+            (ar->size - index) * ar->elem_size);
+
+    memcpy(arrayv_slot(ar, index), element, ar->elem_size);
+    ar->size++;
+
+    return CC_OK;
+}
+
+/**
+ * Replaces an array element at the specified index and optionally copies the
+ * replaced value into the out parameter. The specified index must be within
+ * the bounds of the CC_ArrayV.
+ *
+ * @param[in]  ar      array whose element is being replaced
+ * @param[in]  element pointer to the replacement value
+ * @param[in]  index   index of the element that is being replaced
+ * @param[out] out     pointer to at least <code>elem_size</code> bytes to where
+ *                     the replaced value is copied, or NULL if it is to be
+ *                     ignored
+ *
+ * @return CC_OK if the element was successfully replaced, or CC_ERR_OUT_OF_RANGE
+ *         if the index was out of range.
+ */
+enum cc_stat cc_arrayv_replace_at(CC_ArrayV *ar, const void *element, size_t index, void *out)
+{
+    if (index >= ar->size)
+        return CC_ERR_OUT_OF_RANGE;
+
+    if (out)
+        memcpy(out, arrayv_slot(ar, index), ar->elem_size);
+
+    memcpy(arrayv_slot(ar, index), element, ar->elem_size);
+
+    return CC_OK;
+}
+
+/**
+ * Swaps the values of the elements at the two specified indices.
+ *
+ * @param[in] ar array whose elements are being swapped
+ * @param[in] index1 index of the first element
+ * @param[in] index2 index of the second element
+ *
+ * @return CC_OK if the elements were swapped, or CC_ERR_OUT_OF_RANGE if
+ * either of the indices was out of range.
+ */
+enum cc_stat cc_arrayv_swap_at(CC_ArrayV *ar, size_t index1, size_t index2)
+{
+    if (index1 >= ar->size || index2 >= ar->size)
+        return CC_ERR_OUT_OF_RANGE;
+
+    unsigned char *a = arrayv_slot(ar, index1);
+    unsigned char *b = arrayv_slot(ar, index2);
+
+    size_t i;
+    for (i = 0; i < ar->elem_size; i++) {
+        unsigned char tmp = a[i];
+        a[i] = b[i];
+        b[i] = tmp;
+    }
+    return CC_OK;
+}
+
+/**
+ * Removes a CC_ArrayV element from the specified index and optionally copies
+ * the removed value into the out parameter. The index must be within the
+ * bounds of the array.
+ *
+ * @param[in] ar the array from which the element is being removed
+ * @param[in] index the index of the element being removed.
+ * @param[out] out  pointer to at least <code>elem_size</code> bytes to where
+ *                  the removed value is copied, or NULL if it is to be ignored
+ *
+ * @return CC_OK if the element was successfully removed, or CC_ERR_OUT_OF_RANGE
+ * if the index was out of range.
+ */
+enum cc_stat cc_arrayv_remove_at(CC_ArrayV *ar, size_t index, void *out)
+{
+    if (index >= ar->size)
+        return CC_ERR_OUT_OF_RANGE;
+
+    if (out)
+        memcpy(out, arrayv_slot(ar, index), ar->elem_size);
+
+    if (index != ar->size - 1) {
+        memmove(arrayv_slot(ar, index),
+                arrayv_slot(ar, index + 1),
+                (ar->size - 1 - index) * ar->elem_size);
+    }
+    ar->size--;
+
+    return CC_OK;
+}
+
+/**
+ * Removes the last CC_ArrayV element and optionally copies the removed value
+ * into the out parameter.
+ *
+ * @param[in] ar the array whose last element is being removed
+ * @param[out] out pointer to where the removed value is copied, or NULL if it
+ *                 is to be ignored
+ *
+ * @return CC_OK if the element was successfully removed, or CC_ERR_OUT_OF_RANGE
+ * if the CC_ArrayV is already empty.
+ */
+enum cc_stat cc_arrayv_remove_last(CC_ArrayV *ar, void *out)
+{
+    return cc_arrayv_remove_at(ar, ar->size - 1, out);
+}
+
+/**
+ * Removes all elements from the specified array. This function does not shrink
+ * the array capacity.
+ *
+ * @param[in] ar array from which all elements are to be removed
+ */
+void cc_arrayv_remove_all(CC_ArrayV *ar)
+{
+    ar->size = 0;
+}
+
+/**
+ * Gets a pointer to the CC_ArrayV element at the specified index. The pointer
+ * refers to the value stored inside the array and is only valid until the
+ * array is next modified.
+ *
+ * @param[in] ar the array from which the element is being retrieved
+ * @param[in] index the index of the array element
+ * @param[out] out pointer to where the element pointer is stored
+ *
+ * @return CC_OK if the element was found, or CC_ERR_OUT_OF_RANGE if the index
+ * was out of range.
+ */
+enum cc_stat cc_arrayv_get_at(CC_ArrayV *ar, size_t index, void **out)
+{
+    if (index >= ar->size)
+        return CC_ERR_OUT_OF_RANGE;
+
+    *out = arrayv_slot(ar, index);
+    return CC_OK;
+}
+
+/**
+ * Gets a pointer to the last element of the array.
+ *
+ * @param[in] ar the array whose last element is being returned
+ * @param[out] out pointer to where the element pointer is stored
+ *
+ * @return CC_OK if the element was found, or CC_ERR_VALUE_NOT_FOUND if the
+ * CC_ArrayV is empty.
+ */
+enum cc_stat cc_arrayv_get_last(CC_ArrayV *ar, void **out)
+{
+    if (ar->size == 0)
+        return CC_ERR_VALUE_NOT_FOUND;
+
+    return cc_arrayv_get_at(ar, ar->size - 1, out);
+}
+
+/**
+ * Returns the underlying array buffer holding <code>size * elem_size</code>
+ * bytes of element values.
+ *
+ * @note Any direct modification of the buffer may invalidate the CC_ArrayV.
+ *
+ * @param[in] ar array whose underlying buffer is being returned
+ *
+ * @return array's internal buffer.
+ */
+const void *cc_arrayv_get_buffer(CC_ArrayV *ar)
+{
+    return ar->buffer;
+}
+
+/**
+ * Returns the number of elements within the specified CC_ArrayV that are
+ * equal to the value pointed to by <code>element</code>.
+ *
+ * @param[in] ar array that is being searched
+ * @param[in] element pointer to the value that is being searched for
+ * @param[in] cmp comparator function which returns 0 if the values passed to
+ *                it are equal
+ *
+ * @return the number of occurrences of the value.
+ */
+size_t cc_arrayv_contains_value(CC_ArrayV *ar, const void *element, int (*cmp) (const void*, const void*))
+{
+    size_t o = 0;
+    size_t i;
+    for (i = 0; i < ar->size; i++) {
+        if (cmp(element, arrayv_slot(ar, i)) == 0)
+            o++;
+    }
+    return o;
+}
+
+/**
+ * Returns the number of elements within the specified CC_ArrayV.
+ *
+ * @param[in] ar array whose size is being returned
+ *
+ * @return the the number of element within the CC_ArrayV.
+ */
+size_t cc_arrayv_size(CC_ArrayV *ar)
+{
+    return ar->size;
+}
+
+/**
+ * Returns the number of elements the CC_ArrayV can hold before it has to be
+ * resized.
  *
  * @param[in] ar array whose capacity is being returned
  *
- * @return the capacity of the CC_Array.
+ * @return the capacity of the CC_ArrayV.
  */
-size_t cc_array_capacity(CC_Array *ar)
+size_t cc_arrayv_capacity(CC_ArrayV *ar)
 {
     return ar->capacity;
 }
 
+/**
+ * Returns the size of a single CC_ArrayV element in bytes.
+ *
+ * @param[in] ar array whose element size is being returned
+ *
+ * @return the element size of the CC_ArrayV.
+ */
+size_t cc_arrayv_elem_size(CC_ArrayV *ar)
+{
+    return ar->elem_size;
+}
+
 /**
  * Sorts the specified array.
  *
  * @note
- * Pointers passed to the comparator function will be pointers to the array
- * elements that are of type (void*) ie. void**. So an extra step of
- * dereferencing will be required before the data can be used for comparison:
- * eg. <code>my_type e = *(*((my_type**) ptr));</code>.
- *
- * @code
- * enum cc_stat mycmp(const void *e1, const void *e2) {
- *     MyType el1 = *(*((enum cc_stat**) e1));
- *     MyType el2 = *(*((enum cc_stat**) e2));
+ * Unlike with <code>cc_array_sort()</code>, the pointers passed to the
+ * comparator function point directly to the element values.
  *
- *     if (el1 < el2) return -1;
- *     if (el1 > el2) return 1;
- *     return 0;
- * }
+ * @param[in] ar  array to be sorted
+ * @param[in] cmp the comparator function that returns < 0 if the first
+ *                element goes before the second, 0 if the elements are
+ *                equal and > 0 if the second goes before the first
+ */
+void cc_arrayv_sort(CC_ArrayV *ar, int (*cmp) (const void*, const void*))
+{
+    qsort(ar->buffer, ar->size, ar->elem_size, cmp);
+}
+
+/**
+ * Applies the function fn to a pointer to each element of the CC_ArrayV.
  *
- * ...
+ * @param[in] ar array on which this operation is performed
+ * @param[in] fn operation function that is to be invoked on each CC_ArrayV
+ *               element
+ */
+void cc_arrayv_map(CC_ArrayV *ar, void (*fn) (void *e))
+{
+    size_t i;
+    for (i = 0; i < ar->size; i++)
+        fn(arrayv_slot(ar, i));
+}
+
+/**
+ * Filters the CC_ArrayV by modifying it. It removes all elements that don't
+ * return true on pred(element). The relative order of the kept elements is
+ * preserved.
  *
- * cc_array_sort(array, mycmp);
- * @endcode
+ * @param[in] ar   array that is to be filtered
+ * @param[in] pred predicate function which returns true if the element should
+ *                 be kept in the CC_ArrayV
  *
- * @param[in] ar  array to be sorted
- * @param[in] cmp the comparator function that must be of type <code>
- *                enum cc_stat cmp(const void e1*, const void e2*)</code> that
- *                returns < 0 if the first element goes before the second,
- *                0 if the elements are equal and > 0 if the second goes
- *                before the first
+ * @return CC_OK if the CC_ArrayV was filtered successfully, or
+ * CC_ERR_OUT_OF_RANGE if the CC_ArrayV is empty.
+ */
+enum cc_stat cc_arrayv_filter_mut(CC_ArrayV *ar, bool (*pred) (const void*))
+{
+    if (ar->size == 0)
+        return CC_ERR_OUT_OF_RANGE;
+
+    size_t kept = 0;
+    size_t i;
+    for (i = 0; i < ar->size; i++) {
+        if (!pred(arrayv_slot(ar, i)))
+            continue;
+        if (kept != i)
+            memcpy(arrayv_slot(ar, kept), arrayv_slot(ar, i), ar->elem_size);
+        kept++;
+    }
+    ar->size = kept;
+
+    return CC_OK;
+}
+
+/**
+ * Filters the CC_ArrayV by creating a new CC_ArrayV that contains copies of
+ * all elements from the original CC_ArrayV that return true on
+ * pred(element) without modifying the original CC_ArrayV.
+ *
+ * @param[in] ar   array that is to be filtered
+ * @param[in] pred predicate function which returns true if the element should
+ *                 be kept in the filtered array
+ * @param[out] out pointer to where the new filtered CC_ArrayV is to be stored
+ *
+ * @return CC_OK if the CC_ArrayV was filtered successfully, CC_ERR_OUT_OF_RANGE
+ * if the CC_ArrayV is empty, or CC_ERR_ALLOC if the memory allocation for the
+ * new CC_ArrayV failed.
  */
-void cc_array_sort(CC_Array *ar, int (*cmp) (const void*, const void*))
+enum cc_stat cc_arrayv_filter(CC_ArrayV *ar, bool (*pred) (const void*), CC_ArrayV **out)
 {
-    qsort(ar->buffer, ar->size, sizeof(void*), cmp);
+    if (ar->size == 0)
+        return CC_ERR_OUT_OF_RANGE;
+
+    CC_ArrayV *filtered = ar->mem_alloc(sizeof(CC_ArrayV));
+
+    if (!filtered)
+        return CC_ERR_ALLOC;
+
+    if (!(filtered->buffer = ar->mem_alloc(ar->capacity * ar->elem_size))) {
+        ar->mem_free(filtered);
+        return CC_ERR_ALLOC;
+    }
+
+    filtered->elem_size  = ar->elem_size;
+    filtered->exp_factor = ar->exp_factor;
+    filtered->size       = 0;
+    filtered->capacity   = ar->capacity;
+    filtered->mem_alloc  = ar->mem_alloc;
+    filtered->mem_calloc = ar->mem_calloc;
+    filtered->mem_free   = ar->mem_free;
+
+    size_t i;
+    for (i = 0; i < ar->size; i++) {
+        if (pred(arrayv_slot(ar, i))) {
+            memcpy(arrayv_slot(filtered, filtered->size),
+                   arrayv_slot(ar, i),
+                   ar->elem_size);
+            filtered->size++;
+        }
+    }
+    *out = filtered;
+
+    return CC_OK;
 }
 
 /**
- * Expands the CC_Array capacity. This might fail if the the new buffer
- * cannot be allocated. In case the expansion would overflow the index
- * range, a maximum capacity buffer is allocated instead. If the capacity
- * is already at the maximum capacity, no new buffer is allocated.
+ * Expands the CC_ArrayV capacity. This might fail if the the new buffer
+ * cannot be allocated. In case the expansion would overflow the addressable
+ * byte range, the largest possible buffer is allocated instead.
  *
  * @param[in] ar array whose capacity is being expanded
  *
@@ -839,77 +5244,39 @@ void cc_array_sort(CC_Array *ar, int (*cmp) (const void*, const void*))
  * the memory allocation for the new buffer failed, or CC_ERR_MAX_CAPACITY
  * if the array is already at maximum capacity.
  */
-static enum cc_stat expand_capacity(CC_Array *ar)
+static enum cc_stat arrayv_expand_capacity(CC_ArrayV *ar)
 {
-    if (ar->capacity == CC_MAX_ELEMENTS)
+    size_t max_elements = CC_MAX_ELEMENTS / ar->elem_size;
+
+    if (ar->capacity >= max_elements)
         return CC_ERR_MAX_CAPACITY;
 
     size_t new_capacity = ar->capacity * ar->exp_factor;
 
-    /* As long as the capacity is greater that the expansion factor
-     * at the point of overflow, this is check is valid. */
-    if (new_capacity <= ar->capacity)
-        ar->capacity = CC_MAX_ELEMENTS;
-    else
-        ar->capacity = new_capacity;
+    if (new_capacity <= ar->capacity || new_capacity > max_elements)
+        new_capacity = max_elements;
 
-    void **new_buff = ar->mem_alloc(new_capacity * sizeof(void*));
+    unsigned char *new_buff = ar->mem_alloc(new_capacity * ar->elem_size);
 
     if (!new_buff)
         return CC_ERR_ALLOC;
 
-    memcpy(new_buff, ar->buffer, ar->size * sizeof(void*));
+    memcpy(new_buff, ar->buffer, ar->size * ar->elem_size);
 
     ar->mem_free(ar->buffer);
-    ar->buffer = new_buff;
+    ar->buffer   = new_buff;
+    ar->capacity = new_capacity;
 
     return CC_OK;
 }
 
-/**
- * Applies the function fn to each element of the CC_Array.
- *
- * @param[in] ar array on which this operation is performed
- * @param[in] fn operation function that is to be invoked on each CC_Array
- *               element
- */
-void cc_array_map(CC_Array *ar, void (*fn) (void *e))
-{
-    size_t i;
-    for (i = 0; i < ar->size; i++)
-        fn(ar->buffer[i]);
-}
-
-/**
- * A fold/reduce function that collects all of the elements in the array
- * together. For example, if we have an array of [a,b,c...] the end result
- * will be (...((a+b)+c)+...).
- *
- * @param[in] ar the array on which this operation is performed
- * @param[in] fn the operation function that is to be invoked on each array
- *               element
- * @param[in] result the pointer which will collect the end result
- */
-void cc_array_reduce(CC_Array *ar, void (*fn) (void*, void*, void*), void *result)
-{
-    if (ar->size == 1) {
-        fn(ar->buffer[0], NULL, result);
-        return;
-    }
-    if (ar->size > 1)
-        fn(ar->buffer[0], ar->buffer[1], result);
-
-    for (size_t i = 2; i < ar->size; i++)
-        fn(result, ar->buffer[i], result);
-}
-
 /**
  * Initializes the iterator.
  *
  * @param[in] iter the iterator that is being initialized
  * @param[in] ar the array to iterate over
  */
-void cc_array_iter_init(CC_ArrayIter *iter, CC_Array *ar)
+void cc_arrayv_iter_init(CC_ArrayVIter *iter, CC_ArrayV *ar)
 {
     iter->ar    = ar;
     iter->index = 0;
@@ -917,21 +5284,21 @@ void cc_array_iter_init(CC_ArrayIter *iter, CC_Array *ar)
 }
 
 /**
- * Advances the iterator and sets the out parameter to the value of the
+ * Advances the iterator and sets the out parameter to a pointer to the
  * next element in the sequence.
  *
  * @param[in] iter the iterator that is being advanced
- * @param[out] out pointer to where the next element is set
+ * @param[out] out pointer to where the next element pointer is set
  *
  * @return CC_OK if the iterator was advanced, or CC_ITER_END if the
- * end of the CC_Array has been reached.
+ * end of the CC_ArrayV has been reached.
  */
-enum cc_stat cc_array_iter_next(CC_ArrayIter *iter, void **out)
+enum cc_stat cc_arrayv_iter_next(CC_ArrayVIter *iter, void **out)
 {
     if (iter->index >= iter->ar->size)
         return CC_ITER_END;
 
-    *out = iter->ar->buffer[iter->index];
+    *out = arrayv_slot(iter->ar, iter->index);
 
     iter->index++;
     iter->last_removed = false;
@@ -940,216 +5307,341 @@ enum cc_stat cc_array_iter_next(CC_ArrayIter *iter, void **out)
 }
 
 /**
- * Removes the last returned element by <code>cc_array_iter_next()</code>
- * function without invalidating the iterator and optionally sets the out
- * parameter to the value of the removed element.
+ * Removes the last returned element by <code>cc_arrayv_iter_next()</code>
+ * function without invalidating the iterator and optionally copies the
+ * removed value into the out parameter.
  *
  * @note This function should only ever be called after a call to <code>
- * cc_array_iter_next()</code>.
-
+ * cc_arrayv_iter_next()</code>.
+ *
  * @param[in] iter the iterator on which this operation is being performed
- * @param[out] out pointer to where the removed element is stored, or NULL
+ * @param[out] out pointer to where the removed value is copied, or NULL
  *                 if it is to be ignored
  *
  * @return CC_OK if the element was successfully removed, or
  * CC_ERR_VALUE_NOT_FOUND.
  */
-enum cc_stat cc_array_iter_remove(CC_ArrayIter *iter, void **out)
+enum cc_stat cc_arrayv_iter_remove(CC_ArrayVIter *iter, void *out)
 {
     enum cc_stat status = CC_ERR_VALUE_NOT_FOUND;
 
     if (!iter->last_removed) {
-        status = cc_array_remove_at(iter->ar, iter->index - 1, out);
-        if (status == CC_OK)
+        status = cc_arrayv_remove_at(iter->ar, iter->index - 1, out);
+        if (status == CC_OK) {
+            iter->index--;
             iter->last_removed = true;
+        }
     }
     return status;
 }
 
 /**
- * Adds a new element to the CC_Array after the last returned element by
- * <code>cc_array_iter_next()</code> function without invalidating the
+ * Copies a new element into the CC_ArrayV after the last returned element by
+ * <code>cc_arrayv_iter_next()</code> function without invalidating the
  * iterator.
  *
  * @note This function should only ever be called after a call to <code>
- * cc_array_iter_next()</code>.
+ * cc_arrayv_iter_next()</code>.
  *
  * @param[in] iter the iterator on which this operation is being performed
- * @param[in] element the element being added
+ * @param[in] element pointer to the value being added
  *
  * @return CC_OK if the element was successfully added, CC_ERR_ALLOC if the
  * memory allocation for the new element failed, or CC_ERR_MAX_CAPACITY if
  * the array is already at maximum capacity.
  */
-enum cc_stat cc_array_iter_add(CC_ArrayIter *iter, void *element)
+enum cc_stat cc_arrayv_iter_add(CC_ArrayVIter *iter, const void *element)
 {
-    return cc_array_add_at(iter->ar, element, iter->index++);
+    enum cc_stat status = cc_arrayv_add_at(iter->ar, element, iter->index);
+
+    if (status == CC_OK)
+        iter->index++;
+
+    return status;
 }
 
 /**
- * Replaces the last returned element by <code>cc_array_iter_next()</code>
- * with the specified element and optionally sets the out parameter to
- * the value of the replaced element.
+ * Replaces the last returned element by <code>cc_arrayv_iter_next()</code>
+ * with the specified value and optionally copies the replaced value into
+ * the out parameter.
  *
  * @note This function should only ever be called after a call to <code>
- * cc_array_iter_next()</code>.
+ * cc_arrayv_iter_next()</code>.
  *
  * @param[in] iter the iterator on which this operation is being performed
- * @param[in] element the replacement element
- * @param[out] out pointer to where the replaced element is stored, or NULL
+ * @param[in] element pointer to the replacement value
+ * @param[out] out pointer to where the replaced value is copied, or NULL
  *                if it is to be ignored
  *
  * @return CC_OK if the element was replaced successfully, or
  * CC_ERR_OUT_OF_RANGE.
  */
-enum cc_stat cc_array_iter_replace(CC_ArrayIter *iter, void *element, void **out)
+enum cc_stat cc_arrayv_iter_replace(CC_ArrayVIter *iter, const void *element, void *out)
 {
-    return cc_array_replace_at(iter->ar, element, iter->index - 1, out);
+    return cc_arrayv_replace_at(iter->ar, element, iter->index - 1, out);
 }
 
 /**
- * Returns the index of the last returned element by <code>cc_array_iter_next()
+ * Returns the index of the last returned element by <code>cc_arrayv_iter_next()
  * </code>.
  *
  * @note
- * This function should not be called before a call to <code>cc_array_iter_next()
+ * This function should not be called before a call to <code>cc_arrayv_iter_next()
  * </code>.
  *
  * @param[in] iter the iterator on which this operation is being performed
  *
  * @return the index.
  */
-size_t cc_array_iter_index(CC_ArrayIter *iter)
+size_t cc_arrayv_iter_index(CC_ArrayVIter *iter)
 {
     return iter->index - 1;
 }
 
-/**
- * Initializes the zip iterator.
- *
- * @param[in] iter iterator that is being initialized
- * @param[in] ar1  first array
- * @param[in] ar2  second array
- */
-void cc_array_zip_iter_init(CC_ArrayZipIter *iter, CC_Array *ar1, CC_Array *ar2)
-{
-    iter->ar1 = ar1;
-    iter->ar2 = ar2;
-    iter->index = 0;
-    iter->last_removed = false;
-}
+#define DEFAULT_ARENA_BLOCK_SIZE (64 * 1024)
+
+/* Every allocation is preceded by a header recording its size, which is
+ * needed to implement realloc. The union keeps both the header and the
+ * memory that follows it suitably aligned for any type. */
+typedef union arena_header_u {
+    size_t      size;
+    max_align_t align;
+} ArenaHeader;
+
+typedef struct arena_block_s {
+    struct arena_block_s *next;
+    size_t                capacity;
+    size_t                used;
+    ArenaHeader           data[];
+} ArenaBlock;
+
+struct cc_arena_s {
+    CC_Allocator  allocator;
+    ArenaBlock   *head;
+    size_t        block_size;
+};
+
+static void *arena_alloc   (void *ctx, size_t size);
+static void *arena_calloc  (void *ctx, size_t blocks, size_t size);
+static void *arena_realloc (void *ctx, void *block, size_t size);
+static void  arena_free    (void *ctx, void *block);
 
 /**
- * Outputs the next element pair in the sequence and advances the iterator.
+ * Creates a new arena and returns a status code. No memory is reserved until
+ * the first allocation.
  *
- * @param[in]  iter iterator that is being advanced
- * @param[out] out1 output of the first array element
- * @param[out] out2 output of the second array element
+ * @param[in] block_size minimum size in bytes of the blocks the arena carves
+ *                       allocations from, or 0 for the default size
+ * @param[out] out pointer to where the newly created CC_Arena is to be stored
  *
- * @return CC_OK if a next element pair is returned, or CC_ITER_END if the end of one
- * of the arrays has been reached.
+ * @return CC_OK if the creation was successful, or CC_ERR_ALLOC if the
+ * memory allocation for the new CC_Arena structure failed.
  */
-enum cc_stat cc_array_zip_iter_next(CC_ArrayZipIter *iter, void **out1, void **out2)
+enum cc_stat cc_arena_new(size_t block_size, CC_Arena **out)
 {
-    if (iter->index >= iter->ar1->size || iter->index >= iter->ar2->size)
-        return CC_ITER_END;
+    CC_Arena *arena = calloc(1, sizeof(CC_Arena));
 
-    *out1 = iter->ar1->buffer[iter->index];
-    *out2 = iter->ar2->buffer[iter->index];
+    if (!arena)
+        return CC_ERR_ALLOC;
 
-    iter->index++;
-    iter->last_removed = false;
+    arena->block_size            = block_size ? block_size : DEFAULT_ARENA_BLOCK_SIZE;
+    arena->allocator.mem_alloc   = arena_alloc;
+    arena->allocator.mem_calloc  = arena_calloc;
+    arena->allocator.mem_realloc = arena_realloc;
+    arena->allocator.mem_free    = arena_free;
+    arena->allocator.ctx         = arena;
 
+    *out = arena;
     return CC_OK;
 }
 
 /**
- * Removes and outputs the last returned element pair by <code>cc_array_zip_iter_next()
- * </code> without invalidating the iterator.
+ * Destroys the arena and releases every allocation made from it at once.
  *
- * @param[in]  iter iterator on which this operation is being performed
- * @param[out] out1 output of the removed element from the first array
- * @param[out] out2 output of the removed element from the second array
+ * @param[in] arena the arena that is being destroyed
+ */
+void cc_arena_destroy(CC_Arena *arena)
+{
+    cc_arena_reset(arena);
+    free(arena->head);
+    free(arena);
+}
+
+/**
+ * Releases every allocation made from the arena so that its memory can be
+ * reused. Only the most recently created block is kept.
  *
- * @return CC_OK if the element was successfully removed, CC_ERR_OUT_OF_RANGE if the
- * state of the iterator is invalid, or CC_ERR_VALUE_NOT_FOUND if the element was
- * already removed.
+ * @param[in] arena the arena that is being reset
  */
-enum cc_stat cc_array_zip_iter_remove(CC_ArrayZipIter *iter, void **out1, void **out2)
+void cc_arena_reset(CC_Arena *arena)
 {
-    if ((iter->index - 1) >= iter->ar1->size || (iter->index - 1) >= iter->ar2->size)
-        return CC_ERR_OUT_OF_RANGE;
+    ArenaBlock *block = arena->head;
 
-    if (!iter->last_removed) {
-        cc_array_remove_at(iter->ar1, iter->index - 1, out1);
-        cc_array_remove_at(iter->ar2, iter->index - 1, out2);
-        iter->last_removed = true;
-        return CC_OK;
+    if (!block)
+        return;
+
+    ArenaBlock *next = block->next;
+    while (next) {
+        ArenaBlock *tmp = next->next;
+        free(next);
+        next = tmp;
     }
-    return CC_ERR_VALUE_NOT_FOUND;
+    block->next = NULL;
+    block->used = 0;
 }
 
 /**
- * Adds a new element pair to the arrays after the last returned element pair by
- * <code>cc_array_zip_iter_next()</code> and immediately before an element pair
- * that would be returned by a subsequent call to <code>cc_array_zip_iter_next()</code>
- * without invalidating the iterator.
+ * Returns the number of bytes handed out from the arena's blocks, including
+ * the per allocation bookkeeping.
  *
- * @param[in] iter iterator on which this operation is being performed
- * @param[in] e1   element added to the first array
- * @param[in] e2   element added to the second array
+ * @param[in] arena the arena whose usage is being returned
  *
- * @return CC_OK if the element pair was successfully added to the arrays, or
- * CC_ERR_ALLOC if the memory allocation for the new elements failed.
+ * @return the number of bytes in use.
  */
-enum cc_stat cc_array_zip_iter_add(CC_ArrayZipIter *iter, void *e1, void *e2)
+size_t cc_arena_used(CC_Arena *arena)
 {
-    size_t index = iter->index++;
-    CC_Array  *ar1  = iter->ar1;
-    CC_Array  *ar2  = iter->ar2;
-
-    /* Make sure both array buffers have room */
-    if ((ar1->size == ar1->capacity && (expand_capacity(ar1) != CC_OK)) ||
-            (ar2->size == ar2->capacity && (expand_capacity(ar2) != CC_OK)))
-        return CC_ERR_ALLOC;
-
-    cc_array_add_at(ar1, e1, index);
-    cc_array_add_at(ar2, e2, index);
-
-    return CC_OK;
+    size_t used = 0;
+    ArenaBlock *block;
+    for (block = arena->head; block; block = block->next)
+        used += block->used * sizeof(ArenaHeader);
+    return used;
 }
 
 /**
- * Replaces the last returned element pair by <code>cc_array_zip_iter_next()</code>
- * with the specified replacement element pair.
+ * Returns an allocator that allocates from the specified arena. The returned
+ * allocator is owned by the arena and remains valid until the arena is
+ * destroyed.
  *
- * @param[in] iter  iterator on which this operation is being performed
- * @param[in]  e1   first array's replacement element
- * @param[in]  e2   second array's replacement element
- * @param[out] out1 output of the replaced element from the first array
- * @param[out] out2 output of the replaced element from the second array
+ * @param[in] arena the arena whose allocator is being returned
  *
- * @return CC_OK if the element was successfully replaced, or CC_ERR_OUT_OF_RANGE.
+ * @return the arena's allocator.
  */
-enum cc_stat cc_array_zip_iter_replace(CC_ArrayZipIter *iter, void *e1, void *e2, void **out1, void **out2)
+CC_Allocator const *cc_arena_allocator(CC_Arena *arena)
 {
-    if ((iter->index - 1) >= iter->ar1->size || (iter->index - 1) >= iter->ar2->size)
-        return CC_ERR_OUT_OF_RANGE;
+    return &arena->allocator;
+}
 
-    cc_array_replace_at(iter->ar1, e1, iter->index - 1, out1);
-    cc_array_replace_at(iter->ar2, e2, iter->index - 1, out2);
+/**
+ * Returns the number of header sized units needed to store size bytes, or 0
+ * if the size is too large to be represented.
+ */
+static size_t arena_units(size_t size)
+{
+    if (size > CC_MAX_ELEMENTS - sizeof(ArenaHeader))
+        return 0;
+    return (size + sizeof(ArenaHeader) - 1) / sizeof(ArenaHeader);
+}
 
-    return CC_OK;
+static void *arena_alloc(void *ctx, size_t size)
+{
+    CC_Arena   *arena = ctx;
+    ArenaBlock *block = arena->head;
+    size_t      units = arena_units(size);
+
+    if (!units && size)
+        return NULL;
+
+    /* One extra unit for the header */
+    units++;
+
+    if (!block || block->capacity - block->used < units) {
+        size_t capacity = arena_units(arena->block_size);
+
+        if (capacity < units)
+            capacity = units;
+
+        if (capacity > (CC_MAX_ELEMENTS - sizeof(ArenaBlock)) / sizeof(ArenaHeader))
+            return NULL;
+
+        block = malloc(sizeof(ArenaBlock) + capacity * sizeof(ArenaHeader));
+
+        if (!block)
+            return NULL;
+
+        block->next     = arena->head;
+        block->capacity = capacity;
+        block->used     = 0;
+        arena->head     = block;
+    }
+    ArenaHeader *header = &block->data[block->used];
+    header->size = size;
+    block->used += units;
+
+    return header + 1;
+}
+
+static void *arena_calloc(void *ctx, size_t blocks, size_t size)
+{
+    if (size && blocks > CC_MAX_ELEMENTS / size)
+        return NULL;
+
+    void *mem = arena_alloc(ctx, blocks * size);
+
+    if (mem)
+        memset(mem, 0, blocks * size);
+
+    return mem;
 }
 
 /**
- * Returns the index of the last returned element pair by <code>cc_array_zip_iter_next()</code>.
- *
- * @param[in] iter iterator on which this operation is being performed
- *
- * @return current iterator index.
+ * Returns true if the memory block is the most recent allocation made from
+ * the arena's current block, in which case it can be resized in place.
  */
-size_t cc_array_zip_iter_index(CC_ArrayZipIter *iter)
+static bool arena_is_last(CC_Arena *arena, ArenaHeader *header)
 {
-    return iter->index - 1;
+    ArenaBlock *block = arena->head;
+
+    if (!block)
+        return false;
+
+    return header + 1 + arena_units(header->size) == &block->data[block->used];
+}
+
+static void *arena_realloc(void *ctx, void *mem, size_t size)
+{
+    if (!mem)
+        return arena_alloc(ctx, size);
+
+    CC_Arena    *arena  = ctx;
+    ArenaHeader *header = (ArenaHeader*) mem - 1;
+    size_t       units  = arena_units(size);
+
+    if (!units && size)
+        return NULL;
+
+    if (arena_is_last(arena, header)) {
+        ArenaBlock *block = arena->head;
+        size_t      start = (size_t) (header - block->data);
+
+        if (block->capacity - start - 1 >= units) {
+            block->used  = start + 1 + units;
+            header->size = size;
+            return mem;
+        }
+    } else if (size <= header->size) {
+        header->size = size;
+        return mem;
+    }
+
+    void *new_mem = arena_alloc(ctx, size);
+
+    if (!new_mem)
+        return NULL;
+
+    memcpy(new_mem, mem, header->size < size ? header->size : size);
+    return new_mem;
+}
+
+static void arena_free(void *ctx, void *mem)
+{
+    if (!mem)
+        return;
+
+    CC_Arena    *arena  = ctx;
+    ArenaHeader *header = (ArenaHeader*) mem - 1;
+
+    /* Only the most recent allocation can be given back, everything else
+     * is reclaimed when the arena is reset or destroyed. */
+    if (arena_is_last(arena, header))
+        arena->head->used = (size_t) (header - arena->head->data);
 }
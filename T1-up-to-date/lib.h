@@ -62,6 +62,23 @@ enum cc_stat {
 #endif /* _MSC_VER */
 
 
+/**
+ * Allocator interface whose functions receive a user supplied context
+ * pointer. It can be used in place of the plain mem_alloc / mem_calloc /
+ * mem_free configuration functions when the allocator needs per instance
+ * state, such as an arena.
+ */
+typedef struct cc_allocator_s {
+    void *(*mem_alloc)   (void *ctx, size_t size);
+    void *(*mem_calloc)  (void *ctx, size_t blocks, size_t size);
+    void *(*mem_realloc) (void *ctx, void *block, size_t size);
+    void  (*mem_free)    (void *ctx, void *block);
+
+    /**
+     * Context pointer passed as the first argument to every function */
+    void  *ctx;
+} CC_Allocator;
+
 int cc_common_cmp_str(const void *key1, const void *key2);
 
 #define CC_CMP_STRING cc_common_cmp_str
@@ -101,6 +118,34 @@ int cc_common_cmp_str(const void *key1, const void *key2);
  */
 typedef struct cc_array_s CC_Array;
 
+/**
+ * Strategies used to compute the new capacity when the Array buffer
+ * needs to expand.
+ */
+enum cc_array_growth {
+    /**
+     * Multiply the capacity by the exp_factor of the configuration */
+    CC_ARRAY_GROWTH_FACTOR     = 0,
+
+    /**
+     * Double the capacity using integer arithmetic */
+    CC_ARRAY_GROWTH_DOUBLE     = 1,
+
+    /**
+     * Grow the capacity by half using integer arithmetic */
+    CC_ARRAY_GROWTH_HALF       = 2,
+
+    /**
+     * Add a fixed number of slots while the Array is small and double
+     * the capacity afterwards */
+    CC_ARRAY_GROWTH_ADDITIVE   = 3,
+
+    /**
+     * Double the capacity, round the buffer up to the allocator size class
+     * or to whole pages, and use any slack the allocator hands out */
+    CC_ARRAY_GROWTH_SIZE_CLASS = 4,
+};
+
 /**
  * Array configuration structure. Used to initialize a new Array
  * with specific values.
@@ -120,6 +165,47 @@ typedef struct cc_array_conf_s {
     void *(*mem_alloc)  (size_t size);
     void *(*mem_calloc) (size_t blocks, size_t size);
     void  (*mem_free)   (void *block);
+
+    /**
+     * Optional reallocator, compatible with the above allocators, used to
+     * resize the data buffer in place when possible. If NULL, realloc is
+     * used when mem_alloc and mem_free are malloc and free, and otherwise
+     * resizing allocates a new buffer and copies the elements over. */
+    void *(*mem_realloc) (void *block, size_t size);
+
+    /**
+     * Data buffers of at least this many bytes are mapped directly from the
+     * operating system instead of being allocated through the allocators,
+     * so that they can later be grown and shrunk without copying. Once
+     * mapped, a buffer stays mapped. Zero disables mapping, which is the
+     * default. Only supported on Linux and ignored elsewhere. Also ignored
+     * when a context allocator is set, since memory handed out by it, such
+     * as by an arena, may be released without destroying the Array. */
+    size_t mmap_threshold;
+
+    /**
+     * Optional context carrying allocator. If set, it is used instead of
+     * the above functions and it must outlive the Array and any Array
+     * derived from it. */
+    CC_Allocator const *allocator;
+
+    /**
+     * Number of element slots stored inline in the Array structure. Arrays
+     * whose capacity fits in these slots need no separate buffer allocation
+     * and only spill to the heap once they outgrow them. Zero disables the
+     * inline slots, which is the default. */
+    size_t inline_capacity;
+
+    /**
+     * If true, the buffer is halved whenever removals leave the array at
+     * most a quarter full, but it never shrinks below the initial capacity.
+     * Disabled by default. */
+    bool   auto_shrink;
+
+    /**
+     * The strategy used to expand the buffer. Defaults to
+     * CC_ARRAY_GROWTH_FACTOR, which uses exp_factor. */
+    enum cc_array_growth growth;
 } CC_ArrayConf;
 
 /**
@@ -155,9 +241,40 @@ typedef struct array_zip_iter_s {
     bool      last_removed;
 } CC_ArrayZipIter;
 
+/**
+ * A view of a contiguous range of Array elements. A slice does not own
+ * any memory and is only valid for as long as the range stays within
+ * the bounds of the underlying Array. Since the slice refers to the Array
+ * rather than to its buffer, it survives the buffer being reallocated.
+ */
+typedef struct cc_array_slice_s {
+    /**
+     * The array whose elements are viewed */
+    CC_Array *ar;
+
+    /**
+     * Index of the first element of the slice within the array */
+    size_t    offset;
+
+    /**
+     * Number of elements in the slice */
+    size_t    size;
+} CC_ArraySlice;
+
+/**
+ * Array slice iterator structure. Used to iterate over the elements of
+ * a slice in an ascending order.
+ */
+typedef struct cc_array_slice_iter_s {
+    CC_ArraySlice const *slice;
+    size_t               index;
+} CC_ArraySliceIter;
+
 
 enum cc_stat  cc_array_new             (CC_Array **out);
 enum cc_stat  cc_array_new_conf        (CC_ArrayConf const * const conf, CC_Array **out);
+enum cc_stat  cc_array_new_fixed       (size_t capacity, CC_Array **out);
+enum cc_stat  cc_array_new_fixed_conf  (CC_ArrayConf const * const conf, CC_Array **out);
 void          cc_array_conf_init       (CC_ArrayConf *conf);
 
 void          cc_array_destroy         (CC_Array *ar);
@@ -165,12 +282,20 @@ void          cc_array_destroy_cb      (CC_Array *ar, void (*cb) (void*));
 
 enum cc_stat  cc_array_add             (CC_Array *ar, void *element);
 enum cc_stat  cc_array_add_at          (CC_Array *ar, void *element, size_t index);
+enum cc_stat  cc_array_add_all         (CC_Array *ar, void * const *src, size_t n);
+enum cc_stat  cc_array_add_range_at    (CC_Array *ar, void * const *src, size_t n, size_t index);
+enum cc_stat  cc_array_append_array    (CC_Array *dst, CC_Array *src);
 enum cc_stat  cc_array_replace_at      (CC_Array *ar, void *element, size_t index, void **out);
 enum cc_stat  cc_array_swap_at         (CC_Array *ar, size_t index1, size_t index2);
 
 enum cc_stat  cc_array_remove          (CC_Array *ar, void *element, void **out);
 enum cc_stat  cc_array_remove_at       (CC_Array *ar, size_t index, void **out);
 enum cc_stat  cc_array_remove_last     (CC_Array *ar, void **out);
+enum cc_stat  cc_array_remove_unordered(CC_Array *ar, void *element, void **out);
+enum cc_stat  cc_array_remove_at_unordered(CC_Array *ar, size_t index, void **out);
+enum cc_stat  cc_array_remove_range    (CC_Array *ar, size_t from, size_t to, void **out);
+enum cc_stat  cc_array_remove_indices  (CC_Array *ar, const size_t *indices, size_t n, void (*cb) (void*));
+enum cc_stat  cc_array_remove_indices_unsorted(CC_Array *ar, const size_t *indices, size_t n, void (*cb) (void*));
 void          cc_array_remove_all      (CC_Array *ar);
 void          cc_array_remove_all_free (CC_Array *ar);
 
@@ -179,10 +304,12 @@ enum cc_stat  cc_array_get_last        (CC_Array *ar, void **out);
 
 enum cc_stat  cc_array_subarray        (CC_Array *ar, size_t from, size_t to, CC_Array **out);
 enum cc_stat  cc_array_copy_shallow    (CC_Array *ar, CC_Array **out);
+enum cc_stat  cc_array_copy_cow        (CC_Array *ar, CC_Array **out);
 enum cc_stat  cc_array_copy_deep       (CC_Array *ar, void *(*cp) (void*), CC_Array **out);
 
 void          cc_array_reverse         (CC_Array *ar);
 enum cc_stat  cc_array_trim_capacity   (CC_Array *ar);
+enum cc_stat  cc_array_reserve         (CC_Array *ar, size_t capacity);
 
 size_t        cc_array_contains        (CC_Array *ar, void *element);
 size_t        cc_array_contains_value  (CC_Array *ar, void *element, int (*cmp) (const void*, const void*));
@@ -190,17 +317,39 @@ size_t        cc_array_size            (CC_Array *ar);
 size_t        cc_array_capacity        (CC_Array *ar);
 
 enum cc_stat  cc_array_index_of        (CC_Array *ar, void *element, size_t *index);
+enum cc_stat  cc_array_index_enable    (CC_Array *ar);
+void          cc_array_index_disable   (CC_Array *ar);
 void          cc_array_sort            (CC_Array *ar, int (*cmp) (const void*, const void*));
+enum cc_stat  cc_array_sort_parallel   (CC_Array *ar, int (*cmp) (const void*, const void*), size_t nthreads);
+enum cc_stat  cc_array_sort_stable     (CC_Array *ar, int (*cmp) (const void*, const void*));
+enum cc_stat  cc_array_sort_by_key     (CC_Array *ar, uint64_t (*key) (const void*));
+enum cc_stat  cc_array_select_nth      (CC_Array *ar, size_t index, int (*cmp) (const void*, const void*));
+enum cc_stat  cc_array_partial_sort    (CC_Array *ar, size_t k, int (*cmp) (const void*, const void*));
+enum cc_stat  cc_array_top_k           (CC_Array *ar, size_t k, int (*cmp) (const void*, const void*), CC_Array *dst);
+enum cc_stat  cc_array_sort_stable_scratch(CC_Array *ar, int (*cmp) (const void*, const void*), void **scratch, size_t scratch_size);
+
+void          cc_array_set_sorted      (CC_Array *ar, int (*cmp) (const void*, const void*));
+enum cc_stat  cc_array_bsearch         (CC_Array *ar, void *element, int (*cmp) (const void*, const void*), size_t *index);
+size_t        cc_array_lower_bound     (CC_Array *ar, void *element, int (*cmp) (const void*, const void*));
+size_t        cc_array_upper_bound     (CC_Array *ar, void *element, int (*cmp) (const void*, const void*));
+size_t        cc_array_equal_range     (CC_Array *ar, void *element, int (*cmp) (const void*, const void*), size_t *index);
+enum cc_stat  cc_array_add_sorted      (CC_Array *ar, void *element, int (*cmp) (const void*, const void*));
 
 void          cc_array_map             (CC_Array *ar, void (*fn) (void*));
 void          cc_array_reduce          (CC_Array *ar, void (*fn) (void*, void*, void*), void *result);
 
 enum cc_stat  cc_array_filter_mut      (CC_Array *ar, bool (*predicate) (const void*));
+enum cc_stat  cc_array_filter_mut_unordered(CC_Array *ar, bool (*predicate) (const void*));
+enum cc_stat  cc_array_partition       (CC_Array *ar, bool (*predicate) (const void*), size_t *split);
+enum cc_stat  cc_array_partition_stable(CC_Array *ar, bool (*predicate) (const void*), size_t *split);
 enum cc_stat  cc_array_filter          (CC_Array *ar, bool (*predicate) (const void*), CC_Array **out);
+enum cc_stat  cc_array_filter_into     (CC_Array *ar, bool (*predicate) (const void*), CC_Array *dst);
+size_t        cc_array_count_if        (CC_Array *ar, bool (*predicate) (const void*));
 
 void          cc_array_iter_init       (CC_ArrayIter *iter, CC_Array *ar);
 enum cc_stat  cc_array_iter_next       (CC_ArrayIter *iter, void **out);
 enum cc_stat  cc_array_iter_remove     (CC_ArrayIter *iter, void **out);
+enum cc_stat  cc_array_iter_remove_unordered(CC_ArrayIter *iter, void **out);
 enum cc_stat  cc_array_iter_add        (CC_ArrayIter *iter, void *element);
 enum cc_stat  cc_array_iter_replace    (CC_ArrayIter *iter, void *element, void **out);
 size_t        cc_array_iter_index      (CC_ArrayIter *iter);
@@ -209,10 +358,23 @@ size_t        cc_array_iter_index      (CC_ArrayIter *iter);
 void          cc_array_zip_iter_init   (CC_ArrayZipIter *iter, CC_Array *a1, CC_Array *a2);
 enum cc_stat  cc_array_zip_iter_next   (CC_ArrayZipIter *iter, void **out1, void **out2);
 enum cc_stat  cc_array_zip_iter_add    (CC_ArrayZipIter *iter, void *e1, void *e2);
+enum cc_stat  cc_array_zip_iter_add_range(CC_ArrayZipIter *iter, void * const *src1, void * const *src2, size_t n);
 enum cc_stat  cc_array_zip_iter_remove (CC_ArrayZipIter *iter, void **out1, void **out2);
 enum cc_stat  cc_array_zip_iter_replace(CC_ArrayZipIter *iter, void *e1, void *e2, void **out1, void **out2);
 size_t        cc_array_zip_iter_index  (CC_ArrayZipIter *iter);
 
+enum cc_stat  cc_array_slice           (CC_Array *ar, size_t from, size_t to, CC_ArraySlice *out);
+enum cc_stat  cc_array_slice_get_at    (CC_ArraySlice const *slice, size_t index, void **out);
+size_t        cc_array_slice_size      (CC_ArraySlice const *slice);
+size_t        cc_array_slice_contains  (CC_ArraySlice const *slice, void *element);
+size_t        cc_array_slice_contains_value(CC_ArraySlice const *slice, void *element, int (*cmp) (const void*, const void*));
+void          cc_array_slice_sort      (CC_ArraySlice const *slice, int (*cmp) (const void*, const void*));
+void          cc_array_slice_map       (CC_ArraySlice const *slice, void (*fn) (void*));
+void          cc_array_slice_reduce    (CC_ArraySlice const *slice, void (*fn) (void*, void*, void*), void *result);
+
+void          cc_array_slice_iter_init (CC_ArraySliceIter *iter, CC_ArraySlice const *slice);
+enum cc_stat  cc_array_slice_iter_next (CC_ArraySliceIter *iter, void **out);
+
 const void* const* cc_array_get_buffer(CC_Array *ar);
 
 
@@ -236,4 +398,580 @@ const void* const* cc_array_get_buffer(CC_Array *ar);
             body                                                        \
                 }
 
+
+#define CC_ARRAY_SLICE_FOREACH(val, slice, body)                        \
+    {                                                                   \
+        CC_ArraySliceIter cc_array_slice_iter_5c1e0f7a9b3d2e41;         \
+        cc_array_slice_iter_init(&cc_array_slice_iter_5c1e0f7a9b3d2e41, slice); \
+        void *val;                                                      \
+        while (cc_array_slice_iter_next(&cc_array_slice_iter_5c1e0f7a9b3d2e41, &val) != CC_ITER_END) \
+            body                                                        \
+                }
+
 #endif /* COLLECTIONS_C_ARRAY_H */
+
+#ifndef COLLECTIONS_C_ARRAYV_H
+#define COLLECTIONS_C_ARRAYV_H
+
+/**
+ * A dynamic array that stores its elements by value. Every element occupies
+ * exactly <code>elem_size</code> bytes of a single contiguous buffer, so
+ * adding an element copies it into the array instead of storing a pointer
+ * to it. Functions that return elements return pointers into the buffer
+ * which stay valid until the array is next modified.
+ */
+typedef struct cc_arrayv_s CC_ArrayV;
+
+/**
+ * CC_ArrayV configuration structure. Used to initialize a new CC_ArrayV
+ * with specific values.
+ */
+typedef struct cc_arrayv_conf_s {
+    /**
+     * The size of a single element in bytes */
+    size_t elem_size;
+
+    /**
+     * The initial capacity of the array */
+    size_t capacity;
+
+    /**
+     * The rate at which the buffer expands (capacity * exp_factor). */
+    float  exp_factor;
+
+    /**
+     * Memory allocators used to allocate the CC_ArrayV structure and the
+     * underlying data buffers. */
+    void *(*mem_alloc)  (size_t size);
+    void *(*mem_calloc) (size_t blocks, size_t size);
+    void  (*mem_free)   (void *block);
+} CC_ArrayVConf;
+
+/**
+ * CC_ArrayV iterator structure. Used to iterate over the elements of
+ * the array in an ascending order. The iterator also supports
+ * operations for safely adding and removing elements during
+ * iteration.
+ */
+typedef struct cc_arrayv_iter_s {
+    /**
+     * The array associated with this iterator */
+    CC_ArrayV *ar;
+
+    /**
+     * The current position of the iterator.*/
+    size_t  index;
+
+    /**
+     * Set to true if the last returned element was removed. */
+    bool last_removed;
+} CC_ArrayVIter;
+
+
+enum cc_stat  cc_arrayv_new            (size_t elem_size, CC_ArrayV **out);
+enum cc_stat  cc_arrayv_new_conf       (CC_ArrayVConf const * const conf, CC_ArrayV **out);
+void          cc_arrayv_conf_init      (CC_ArrayVConf *conf, size_t elem_size);
+
+void          cc_arrayv_destroy        (CC_ArrayV *ar);
+void          cc_arrayv_destroy_cb     (CC_ArrayV *ar, void (*cb) (void*));
+
+enum cc_stat  cc_arrayv_add            (CC_ArrayV *ar, const void *element);
+enum cc_stat  cc_arrayv_add_at         (CC_ArrayV *ar, const void *element, size_t index);
+enum cc_stat  cc_arrayv_replace_at     (CC_ArrayV *ar, const void *element, size_t index, void *out);
+enum cc_stat  cc_arrayv_swap_at        (CC_ArrayV *ar, size_t index1, size_t index2);
+
+enum cc_stat  cc_arrayv_remove_at      (CC_ArrayV *ar, size_t index, void *out);
+enum cc_stat  cc_arrayv_remove_last    (CC_ArrayV *ar, void *out);
+void          cc_arrayv_remove_all     (CC_ArrayV *ar);
+
+enum cc_stat  cc_arrayv_get_at         (CC_ArrayV *ar, size_t index, void **out);
+enum cc_stat  cc_arrayv_get_last       (CC_ArrayV *ar, void **out);
+
+size_t        cc_arrayv_contains_value (CC_ArrayV *ar, const void *element, int (*cmp) (const void*, const void*));
+size_t        cc_arrayv_size           (CC_ArrayV *ar);
+size_t        cc_arrayv_capacity       (CC_ArrayV *ar);
+size_t        cc_arrayv_elem_size      (CC_ArrayV *ar);
+
+void          cc_arrayv_sort           (CC_ArrayV *ar, int (*cmp) (const void*, const void*));
+void          cc_arrayv_map            (CC_ArrayV *ar, void (*fn) (void*));
+
+enum cc_stat  cc_arrayv_filter_mut     (CC_ArrayV *ar, bool (*predicate) (const void*));
+enum cc_stat  cc_arrayv_filter         (CC_ArrayV *ar, bool (*predicate) (const void*), CC_ArrayV **out);
+
+void          cc_arrayv_iter_init      (CC_ArrayVIter *iter, CC_ArrayV *ar);
+enum cc_stat  cc_arrayv_iter_next      (CC_ArrayVIter *iter, void **out);
+enum cc_stat  cc_arrayv_iter_remove    (CC_ArrayVIter *iter, void *out);
+enum cc_stat  cc_arrayv_iter_add       (CC_ArrayVIter *iter, const void *element);
+enum cc_stat  cc_arrayv_iter_replace   (CC_ArrayVIter *iter, const void *element, void *out);
+size_t        cc_arrayv_iter_index     (CC_ArrayVIter *iter);
+
+const void*   cc_arrayv_get_buffer     (CC_ArrayV *ar);
+
+
+#define CC_ARRAYV_FOREACH(val, array, body)                             \
+    {                                                                   \
+        CC_ArrayVIter cc_arrayv_iter_9f1c3b07d2e84a65;                  \
+        cc_arrayv_iter_init(&cc_arrayv_iter_9f1c3b07d2e84a65, array);   \
+        void *val;                                                      \
+        while (cc_arrayv_iter_next(&cc_arrayv_iter_9f1c3b07d2e84a65, &val) != CC_ITER_END) \
+            body                                                        \
+                }
+
+#endif /* COLLECTIONS_C_ARRAYV_H */
+
+#ifndef COLLECTIONS_C_ARRAY_TYPED_H
+#define COLLECTIONS_C_ARRAY_TYPED_H
+
+/**
+ * Declares <code>void name(T *base, size_t n)</code>, a function that sorts
+ * the n elements of type <code>T</code> starting at <code>base</code> with a
+ * pattern-defeating introsort. The comparator is called directly rather than
+ * through a pointer, so the compiler is free to inline it. The sort is not
+ * stable.
+ *
+ * Partitions use a median of three, or Tukey's ninther for more than 128
+ * elements, as the pivot and are finished with an insertion sort below 24
+ * elements. Runs of elements equal to an earlier pivot are skipped in
+ * linear time, already sorted partitions are detected, and a heapsort takes
+ * over after too many unbalanced partitions, which keeps the worst case at
+ * O(n log n).
+ *
+ * <code>cmp</code> must be a function (or function-like macro) of the form
+ * <code>int cmp(const T *e1, const T *e2)</code> with the same meaning as the
+ * comparator of <code>CC_ARRAY_DECLARE</code>. Helper functions prefixed
+ * with <code>name_</code> are declared as well.
+ */
+#define CC_SORT_DECLARE(name, T, cmp)                                          \
+                                                                               \
+static INLINE void name##_swap(T *a, T *b)                                     \
+{                                                                              \
+    T tmp = *a;                                                                \
+    *a = *b;                                                                   \
+    *b = tmp;                                                                  \
+}                                                                              \
+                                                                               \
+static INLINE void name##_order3(T *a, T *b, T *c)                             \
+{                                                                              \
+    if (cmp(b, a) < 0)                                                         \
+        name##_swap(a, b);                                                     \
+    if (cmp(c, b) < 0) {                                                       \
+        name##_swap(b, c);                                                     \
+        if (cmp(b, a) < 0)                                                     \
+            name##_swap(a, b);                                                 \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+static INLINE void name##_insertion(T *base, size_t n)                         \
+{                                                                              \
+    for (size_t i = 1; i < n; i++) {                                           \
+        T tmp    = base[i];                                                    \
+        size_t j = i;                                                          \
+        for (; j > 0 && cmp(&tmp, &base[j - 1]) < 0; j--)                      \
+            base[j] = base[j - 1];                                             \
+        base[j] = tmp;                                                         \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+static INLINE bool name##_partial_insertion(T *base, size_t n)                 \
+{                                                                              \
+    size_t moves = 0;                                                          \
+    for (size_t i = 1; i < n; i++) {                                           \
+        if (cmp(&base[i], &base[i - 1]) >= 0)                                  \
+            continue;                                                          \
+        T tmp    = base[i];                                                    \
+        size_t j = i;                                                          \
+        do {                                                                   \
+            base[j] = base[j - 1];                                             \
+            j--;                                                               \
+        } while (j > 0 && cmp(&tmp, &base[j - 1]) < 0);                        \
+        base[j] = tmp;                                                         \
+        moves += i - j;                                                        \
+        if (moves > 8)                                                         \
+            return false;                                                      \
+    }                                                                          \
+    return true;                                                               \
+}                                                                              \
+                                                                               \
+static INLINE void name##_sift_down(T *base, size_t root, size_t n)            \
+{                                                                              \
+    T tmp = base[root];                                                        \
+    for (;;) {                                                                 \
+        size_t child = 2 * root + 1;                                           \
+        if (child >= n)                                                        \
+            break;                                                             \
+        if (child + 1 < n && cmp(&base[child], &base[child + 1]) < 0)          \
+            child++;                                                           \
+        if (cmp(&tmp, &base[child]) >= 0)                                      \
+            break;                                                             \
+        base[root] = base[child];                                              \
+        root = child;                                                          \
+    }                                                                          \
+    base[root] = tmp;                                                          \
+}                                                                              \
+                                                                               \
+static INLINE void name##_heap(T *base, size_t n)                              \
+{                                                                              \
+    for (size_t i = n / 2; i-- > 0;)                                           \
+        name##_sift_down(base, i, n);                                          \
+    for (size_t i = n; i-- > 1;) {                                             \
+        name##_swap(&base[0], &base[i]);                                       \
+        name##_sift_down(base, 0, i);                                          \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+static INLINE size_t name##_partition_right(T *base, size_t n, bool *sorted)   \
+{                                                                              \
+    T pivot      = base[0];                                                    \
+    size_t first = 0;                                                          \
+    size_t last  = n;                                                          \
+                                                                               \
+    while (cmp(&base[++first], &pivot) < 0);                                   \
+    if (first == 1) {                                                          \
+        while (first < last && cmp(&base[--last], &pivot) >= 0);               \
+    } else {                                                                   \
+        while (cmp(&base[--last], &pivot) >= 0);                               \
+    }                                                                          \
+    *sorted = first >= last;                                                   \
+                                                                               \
+    while (first < last) {                                                     \
+        name##_swap(&base[first], &base[last]);                                \
+        while (cmp(&base[++first], &pivot) < 0);                               \
+        while (cmp(&base[--last], &pivot) >= 0);                               \
+    }                                                                          \
+    base[0]         = base[first - 1];                                         \
+    base[first - 1] = pivot;                                                   \
+    return first - 1;                                                          \
+}                                                                              \
+                                                                               \
+static INLINE size_t name##_partition_left(T *base, size_t n)                  \
+{                                                                              \
+    T pivot      = base[0];                                                    \
+    size_t first = 0;                                                          \
+    size_t last  = n;                                                          \
+                                                                               \
+    while (cmp(&pivot, &base[--last]) < 0);                                    \
+    if (last + 1 == n) {                                                       \
+        while (first < last && cmp(&pivot, &base[++first]) >= 0);              \
+    } else {                                                                   \
+        while (cmp(&pivot, &base[++first]) >= 0);                              \
+    }                                                                          \
+                                                                               \
+    while (first < last) {                                                     \
+        name##_swap(&base[first], &base[last]);                                \
+        while (cmp(&pivot, &base[--last]) < 0);                                \
+        while (cmp(&pivot, &base[++first]) >= 0);                              \
+    }                                                                          \
+    base[0]    = base[last];                                                   \
+    base[last] = pivot;                                                        \
+    return last;                                                               \
+}                                                                              \
+                                                                               \
+static INLINE void name##_break_pattern(T *base, size_t n)                     \
+{                                                                              \
+    if (n < 24)                                                                \
+        return;                                                                \
+    size_t q = n / 4;                                                          \
+    name##_swap(&base[0], &base[q]);                                           \
+    name##_swap(&base[n - 1], &base[n - q]);                                   \
+    if (n > 128) {                                                             \
+        name##_swap(&base[1], &base[q + 1]);                                   \
+        name##_swap(&base[2], &base[q + 2]);                                   \
+        name##_swap(&base[n - 2], &base[n - q - 1]);                           \
+        name##_swap(&base[n - 3], &base[n - q - 2]);                           \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+static INLINE void name##_loop(T *base, size_t n, unsigned bad, bool leftmost) \
+{                                                                              \
+    while (n >= 24) {                                                          \
+        size_t half = n / 2;                                                   \
+        if (n > 128) {                                                         \
+            name##_order3(&base[0], &base[half], &base[n - 1]);                \
+            name##_order3(&base[1], &base[half - 1], &base[n - 2]);            \
+            name##_order3(&base[2], &base[half + 1], &base[n - 3]);            \
+            name##_order3(&base[half - 1], &base[half], &base[half + 1]);      \
+            name##_swap(&base[0], &base[half]);                                \
+        } else {                                                               \
+            name##_order3(&base[half], &base[0], &base[n - 1]);                \
+        }                                                                      \
+                                                                               \
+        if (!leftmost && cmp(&base[-1], &base[0]) >= 0) {                      \
+            size_t p = name##_partition_left(base, n) + 1;                     \
+            base += p;                                                         \
+            n    -= p;                                                         \
+            continue;                                                          \
+        }                                                                      \
+                                                                               \
+        bool sorted;                                                           \
+        size_t p = name##_partition_right(base, n, &sorted);                   \
+        size_t l = p;                                                          \
+        size_t r = n - p - 1;                                                  \
+                                                                               \
+        if (l < n / 8 || r < n / 8) {                                          \
+            if (--bad == 0) {                                                  \
+                name##_heap(base, n);                                          \
+                return;                                                        \
+            }                                                                  \
+            name##_break_pattern(base, l);                                     \
+            name##_break_pattern(base + p + 1, r);                             \
+        } else if (sorted &&                                                   \
+                   name##_partial_insertion(base, l) &&                        \
+                   name##_partial_insertion(base + p + 1, r)) {                \
+            return;                                                            \
+        }                                                                      \
+                                                                               \
+        if (l < r) {                                                           \
+            name##_loop(base, l, bad, leftmost);                               \
+            base    += p + 1;                                                  \
+            n        = r;                                                      \
+            leftmost = false;                                                  \
+        } else {                                                               \
+            name##_loop(base + p + 1, r, bad, false);                          \
+            n = l;                                                             \
+        }                                                                      \
+    }                                                                          \
+    name##_insertion(base, n);                                                 \
+}                                                                              \
+                                                                               \
+static INLINE void name(T *base, size_t n)                                     \
+{                                                                              \
+    unsigned bad = 1;                                                          \
+    for (size_t m = n; m > 1; m >>= 1)                                         \
+        bad++;                                                                 \
+    name##_loop(base, n, bad, true);                                           \
+}
+
+
+/**
+ * Declares a type-specialized dynamic array called <code>name</code> that
+ * stores elements of type <code>T</code> by value. Unlike CC_Array, the
+ * structure is not opaque and every function is generated as
+ * <code>static inline</code>, so the compiler is free to inline element
+ * access, and the comparator used by sorting, into the calling code.
+ *
+ * <code>cmp</code> must be a function (or function-like macro) of the form
+ * <code>int cmp(const T *e1, const T *e2)</code> that returns < 0 if the
+ * first element goes before the second, 0 if the elements are equal and
+ * > 0 if the second goes before the first.
+ *
+ * The generated array is backed by <code>malloc</code>, <code>realloc</code>
+ * and <code>free</code> and provides:
+ *
+ * @code
+ * enum cc_stat name_init        (name *ar, size_t capacity);
+ * void         name_destroy     (name *ar);
+ * enum cc_stat name_reserve     (name *ar, size_t capacity);
+ * enum cc_stat name_add         (name *ar, T element);
+ * enum cc_stat name_add_at      (name *ar, T element, size_t index);
+ * enum cc_stat name_replace_at  (name *ar, T element, size_t index, T *out);
+ * enum cc_stat name_get_at      (const name *ar, size_t index, T *out);
+ * enum cc_stat name_remove_at   (name *ar, size_t index, T *out);
+ * enum cc_stat name_remove_last (name *ar, T *out);
+ * size_t       name_size        (const name *ar);
+ * void         name_sort        (name *ar);
+ * void         name_sort_buffer (T *base, size_t n);
+ * void         name_iter_init   (name_iter *iter, name *ar);
+ * enum cc_stat name_iter_next   (name_iter *iter, T **out);
+ * @endcode
+ *
+ * The <code>out</code> parameters may be NULL if the value is to be
+ * ignored, except for <code>name_get_at()</code>.
+ */
+#define CC_ARRAY_DECLARE(name, T, cmp)                                         \
+                                                                               \
+typedef T name##_elem;                                                         \
+                                                                               \
+typedef struct name##_s {                                                      \
+    size_t  size;                                                              \
+    size_t  capacity;                                                          \
+    T      *buffer;                                                            \
+} name;                                                                        \
+                                                                               \
+typedef struct name##_iter_s {                                                 \
+    name   *ar;                                                                \
+    size_t  index;                                                             \
+} name##_iter;                                                                 \
+                                                                               \
+static INLINE enum cc_stat name##_init(name *ar, size_t capacity)              \
+{                                                                              \
+    if (!capacity || capacity > CC_MAX_ELEMENTS / sizeof(T))                   \
+        return CC_ERR_INVALID_CAPACITY;                                        \
+                                                                               \
+    if (!(ar->buffer = malloc(capacity * sizeof(T))))                          \
+        return CC_ERR_ALLOC;                                                   \
+                                                                               \
+    ar->size     = 0;                                                          \
+    ar->capacity = capacity;                                                   \
+    return CC_OK;                                                              \
+}                                                                              \
+                                                                               \
+static INLINE void name##_destroy(name *ar)                                    \
+{                                                                              \
+    free(ar->buffer);                                                          \
+    ar->buffer   = NULL;                                                       \
+    ar->size     = 0;                                                          \
+    ar->capacity = 0;                                                          \
+}                                                                              \
+                                                                               \
+static INLINE enum cc_stat name##_reserve(name *ar, size_t capacity)           \
+{                                                                              \
+    const size_t max_capacity = CC_MAX_ELEMENTS / sizeof(T);                   \
+                                                                               \
+    if (capacity <= ar->capacity)                                              \
+        return CC_OK;                                                          \
+    if (capacity > max_capacity)                                               \
+        return CC_ERR_MAX_CAPACITY;                                            \
+                                                                               \
+    size_t new_capacity = ar->capacity > max_capacity / 2 ?                    \
+        max_capacity : ar->capacity * 2;                                       \
+    if (new_capacity < capacity)                                               \
+        new_capacity = capacity;                                               \
+                                                                               \
+    T *new_buff = realloc(ar->buffer, new_capacity * sizeof(T));               \
+    if (!new_buff)                                                             \
+        return CC_ERR_ALLOC;                                                   \
+                                                                               \
+    ar->buffer   = new_buff;                                                   \
+    ar->capacity = new_capacity;                                               \
+    return CC_OK;                                                              \
+}                                                                              \
+                                                                               \
+static INLINE enum cc_stat name##_add(name *ar, T element)                     \
+{                                                                              \
+    if (ar->size >= ar->capacity) {                                            \
+        if (ar->size == CC_MAX_ELEMENTS)                                       \
+            return CC_ERR_MAX_CAPACITY;                                        \
+        enum cc_stat status = name##_reserve(ar, ar->size + 1);                \
+        if (status != CC_OK)                                                   \
+            return status;                                                     \
+    }                                                                          \
+    ar->buffer[ar->size++] = element;                                          \
+    return CC_OK;                                                              \
+}                                                                              \
+                                                                               \
+static INLINE enum cc_stat name##_add_at(name *ar, T element, size_t index)    \
+{                                                                              \
+    if (index == ar->size)                                                     \
+        return name##_add(ar, element);                                        \
+    if (index > ar->size)                                                      \
+        return CC_ERR_OUT_OF_RANGE;                                            \
+                                                                               \
+    if (ar->size >= ar->capacity) {                                            \
+        enum cc_stat status = name##_reserve(ar, ar->size + 1);                \
+        if (status != CC_OK)                                                   \
+            return status;                                                     \
+    }                                                                          \
+    memmove(&ar->buffer[index + 1],                                            \
+            &ar->buffer[index],                                                \
+            (ar->size - index) * sizeof(T));                                   \
+                                                                               \
+    ar->buffer[index] = element;                                               \
+    ar->size++;                                                                \
+    return CC_OK;                                                              \
+}                                                                              \
+                                                                               \
+static INLINE enum cc_stat name##_replace_at(name *ar, T element,              \
+                                             size_t index, T *out)             \
+{                                                                              \
+    if (index >= ar->size)                                                     \
+        return CC_ERR_OUT_OF_RANGE;                                            \
+    if (out)                                                                   \
+        *out = ar->buffer[index];                                              \
+    ar->buffer[index] = element;                                               \
+    return CC_OK;                                                              \
+}                                                                              \
+                                                                               \
+static INLINE enum cc_stat name##_get_at(const name *ar, size_t index, T *out) \
+{                                                                              \
+    if (index >= ar->size)                                                     \
+        return CC_ERR_OUT_OF_RANGE;                                            \
+    *out = ar->buffer[index];                                                  \
+    return CC_OK;                                                              \
+}                                                                              \
+                                                                               \
+static INLINE enum cc_stat name##_remove_at(name *ar, size_t index, T *out)    \
+{                                                                              \
+    if (index >= ar->size)                                                     \
+        return CC_ERR_OUT_OF_RANGE;                                            \
+    if (out)                                                                   \
+        *out = ar->buffer[index];                                              \
+                                                                               \
+    memmove(&ar->buffer[index],                                                \
+            &ar->buffer[index + 1],                                            \
+            (ar->size - 1 - index) * sizeof(T));                               \
+    ar->size--;                                                                \
+    return CC_OK;                                                              \
+}                                                                              \
+                                                                               \
+static INLINE enum cc_stat name##_remove_last(name *ar, T *out)                \
+{                                                                              \
+    if (ar->size == 0)                                                         \
+        return CC_ERR_OUT_OF_RANGE;                                            \
+    ar->size--;                                                                \
+    if (out)                                                                   \
+        *out = ar->buffer[ar->size];                                           \
+    return CC_OK;                                                              \
+}                                                                              \
+                                                                               \
+static INLINE size_t name##_size(const name *ar)                               \
+{                                                                              \
+    return ar->size;                                                           \
+}                                                                              \
+                                                                               \
+CC_SORT_DECLARE(name##_sort_buffer, T, cmp)                                    \
+                                                                               \
+static INLINE void name##_sort(name *ar)                                       \
+{                                                                              \
+    name##_sort_buffer(ar->buffer, ar->size);                                  \
+}                                                                              \
+                                                                               \
+static INLINE void name##_iter_init(name##_iter *iter, name *ar)               \
+{                                                                              \
+    iter->ar    = ar;                                                          \
+    iter->index = 0;                                                           \
+}                                                                              \
+                                                                               \
+static INLINE enum cc_stat name##_iter_next(name##_iter *iter, T **out)        \
+{                                                                              \
+    if (iter->index >= iter->ar->size)                                         \
+        return CC_ITER_END;                                                    \
+    *out = &iter->ar->buffer[iter->index++];                                   \
+    return CC_OK;                                                              \
+}
+
+
+/**
+ * Iterates over an array declared with <code>CC_ARRAY_DECLARE</code>. The
+ * <code>val</code> variable is a pointer to the current element.
+ */
+#define CC_ARRAY_TYPED_FOREACH(name, val, array, body)                         \
+    {                                                                          \
+        name##_iter cc_array_typed_iter_c6a81f0d3b92e457;                      \
+        name##_iter_init(&cc_array_typed_iter_c6a81f0d3b92e457, array);        \
+        name##_elem *val;                                                      \
+        while (name##_iter_next(&cc_array_typed_iter_c6a81f0d3b92e457, &val) != CC_ITER_END) \
+            body                                                               \
+                }
+
+#endif /* COLLECTIONS_C_ARRAY_TYPED_H */
+
+#ifndef COLLECTIONS_C_ARENA_H
+#define COLLECTIONS_C_ARENA_H
+
+/**
+ * A bump allocator that carves allocations out of large blocks. Individual
+ * frees are no-ops (except for the most recent allocation), and all memory
+ * handed out by the arena is released at once by either resetting or
+ * destroying it. Use <code>cc_arena_allocator()</code> to plug the arena
+ * into a container configuration.
+ */
+typedef struct cc_arena_s CC_Arena;
+
+enum cc_stat        cc_arena_new       (size_t block_size, CC_Arena **out);
+void                cc_arena_destroy   (CC_Arena *arena);
+void                cc_arena_reset     (CC_Arena *arena);
+size_t              cc_arena_used      (CC_Arena *arena);
+
+CC_Allocator const* cc_arena_allocator (CC_Arena *arena);
+
+#endif /* COLLECTIONS_C_ARENA_H */
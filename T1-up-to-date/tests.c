@@ -13,6 +13,19 @@ struct cc_array_s
   void *(*mem_alloc)(size_t size);
   void *(*mem_calloc)(size_t blocks, size_t size);
   void (*mem_free)(void *block);
+  void *(*mem_realloc)(void *block, size_t size);
+  CC_Allocator const *allocator;
+  size_t mmap_threshold;
+  size_t mapped;
+  size_t inline_capacity;
+  bool fixed;
+  bool auto_shrink;
+  size_t min_capacity;
+  enum cc_array_growth growth;
+  size_t *refs;
+  void *index;
+  int (*sorted_cmp)(const void *, const void *);
+  void *inline_buf[];
 };
 
 #define DEFAULT_CAPACITY 8
@@ -1228,7 +1241,7 @@ bool test_cc_array_zip_iter_replace_success_check_elements() {
 }
 
 bool test_cc_array_new_conf_exp_factor_equal_1() {
-    CC_ArrayConf conf;
+    CC_ArrayConf conf = {0};
     conf.exp_factor = 1;  // Set exp_factor to 1
     conf.capacity = 10;   // Set capacity to any value
     conf.mem_alloc = malloc;
@@ -1244,7 +1257,7 @@ bool test_cc_array_new_conf_exp_factor_equal_1() {
 }
 
 bool test_cc_array_new_conf_exp_factor_equal_0() {
-    CC_ArrayConf conf;
+    CC_ArrayConf conf = {0};
     conf.exp_factor = 0;  // Set exp_factor to 0
     conf.capacity = 10;   // Set capacity to any value
     conf.mem_alloc = malloc;
@@ -1265,7 +1278,7 @@ enum cc_stat test_expand_capacity(CC_Array *ar) {
 
 bool test_cc_array_add_status_not_greater_than_CC_OK() {
     // Setup array
-    CC_Array array;
+    CC_Array array = {0};
     array.size = 1;
     array.capacity = 1;
     void *buffer[1];
@@ -1284,7 +1297,7 @@ bool test_cc_array_add_status_not_greater_than_CC_OK() {
 
 bool test_cc_array_add_pre_increment_size() {
     // Setup array
-    CC_Array array;
+    CC_Array array = {0};
     array.size = 1;
     array.capacity = 2;
     void *buffer[2];
@@ -1310,7 +1323,7 @@ bool test_cc_array_add_pre_increment_size() {
 
 bool test_cc_array_add_at_index_out_of_range() {
     // Setup array
-    CC_Array array;
+    CC_Array array = {0};
     array.size = 2;
     array.capacity = 2;
     void *buffer[2];
@@ -1332,7 +1345,7 @@ bool test_cc_array_add_at_index_out_of_range() {
 
 bool test_cc_array_add_at_max_index() {
     // Setup array
-    CC_Array array;
+    CC_Array array = {0};
     array.size = 2;
     array.capacity = 2;
     void *buffer[2];
@@ -1357,7 +1370,7 @@ bool test_cc_array_add_at_max_index() {
 
 bool test_cc_array_add_at_with_index_zero_in_empty_array() {
     // Setup array
-    CC_Array array;
+    CC_Array array = {0};
     array.size = 0;
     array.capacity = 2;
     void *buffer[2];
@@ -1375,7 +1388,7 @@ bool test_cc_array_add_at_with_index_zero_in_empty_array() {
 
 bool test_expand_capacity_called_when_size_greater_than_capacity() {
     // Setup array
-    CC_Array array;
+    CC_Array array = {0};
     array.size = 5;
     array.capacity = 4; // size > capacity
     void *buffer[4];
@@ -1394,7 +1407,7 @@ bool test_expand_capacity_called_when_size_greater_than_capacity() {
 
 bool test_expand_capacity_not_called_when_size_less_than_capacity() {
     // Setup array
-    CC_Array array;
+    CC_Array array = {0};
     array.size = 2;
     array.capacity = 4; // size < capacity
     void *buffer[4];
@@ -2133,7 +2146,7 @@ bool test_reduce_size_minus_1() {
 
 bool new_test() {
     CC_Array* a;
-    CC_ArrayConf conf;
+    CC_ArrayConf conf = {0};
     cc_array_conf_init(&conf);
     conf.capacity = 10;
     conf.exp_factor = 2;
@@ -3619,7 +3632,7 @@ bool float_equal(float a, float b, float epsilon) {
 
 // Test configuration with expansion factor <= 1
 bool test_exp_factor_leq_1() {
-    CC_ArrayConf conf;
+    CC_ArrayConf conf = {0};
     CC_Array* array;
 
     // Set up the configuration
@@ -3643,7 +3656,7 @@ bool test_exp_factor_leq_1() {
 
 // Test configuration with expansion factor > 1
 bool test_exp_factor_gt_1() {
-    CC_ArrayConf conf;
+    CC_ArrayConf conf = {0};
     CC_Array* array;
 
     // Set up the configuration
@@ -3662,7 +3675,7 @@ bool test_exp_factor_gt_1() {
 
 // Test configuration with capacity == 0
 bool test_invalid_capacity() {
-    CC_ArrayConf conf;
+    CC_ArrayConf conf = {0};
     CC_Array* array;
 
     // Set up the configuration
@@ -3680,7 +3693,7 @@ bool test_invalid_capacity() {
 
 // Test configuration with valid capacity and expansion factor
 bool test_valid_capacity_and_exp_factor() {
-    CC_ArrayConf conf;
+    CC_ArrayConf conf = {0};
     CC_Array* array;
 
     // Set up the configuration
@@ -3699,7 +3712,7 @@ bool test_valid_capacity_and_exp_factor() {
 
 // Test configuration with expansion factor large enough to cause overflow
 bool test_exp_factor_causes_overflow() {
-    CC_ArrayConf conf;
+    CC_ArrayConf conf = {0};
     CC_Array* array;
 
     // Set up the configuration
@@ -3909,7 +3922,7 @@ bool test_add_at_out_of_bounds() {
 
 // Test adding element when array is full and requires expansion
 bool test_add_at_full_array() {
-    CC_ArrayConf conf;
+    CC_ArrayConf conf = {0};
     CC_Array* a;
 
     // Set up the configuration
@@ -5387,6 +5400,2018 @@ bool test_cc_array_zip_iter_replace_mutant_no_subtract() {
     return true;
 }
 
+typedef struct {
+    int    id;
+    double score;
+} arrayv_rec;
+
+static int arrayv_rec_cmp(const void *a, const void *b)
+{
+    const arrayv_rec *r1 = a;
+    const arrayv_rec *r2 = b;
+    return (r1->id > r2->id) - (r1->id < r2->id);
+}
+
+static bool arrayv_rec_even(const void *e)
+{
+    return ((const arrayv_rec*) e)->id % 2 == 0;
+}
+
+bool test_cc_arrayv_add_get_by_value() {
+    CC_ArrayV *ar;
+    ASSERT_CC_OK(cc_arrayv_new(sizeof(arrayv_rec), &ar));
+
+    for (int i = 0; i < 100; i++) {
+        arrayv_rec r = {i, i * 0.5};
+        ASSERT_CC_OK(cc_arrayv_add(ar, &r));
+    }
+    ASSERT_EQ(100, cc_arrayv_size(ar));
+
+    void *e;
+    ASSERT_CC_OK(cc_arrayv_get_at(ar, 42, &e));
+    ASSERT_EQ(42, ((arrayv_rec*) e)->id);
+    ASSERT_TRUE(((arrayv_rec*) e)->score == 21.0);
+    ASSERT_EQ(CC_ERR_OUT_OF_RANGE, cc_arrayv_get_at(ar, 100, &e));
+
+    /* Values are contiguous in the buffer */
+    const arrayv_rec *buf = cc_arrayv_get_buffer(ar);
+    ASSERT_EQ(99, buf[99].id);
+
+    cc_arrayv_destroy(ar);
+    return true;
+}
+
+bool test_cc_arrayv_add_at_remove_at() {
+    CC_ArrayV *ar;
+    ASSERT_CC_OK(cc_arrayv_new(sizeof(int), &ar));
+
+    int v[] = {1, 2, 4};
+    for (int i = 0; i < 3; i++)
+        ASSERT_CC_OK(cc_arrayv_add(ar, &v[i]));
+
+    int three = 3;
+    ASSERT_CC_OK(cc_arrayv_add_at(ar, &three, 2));
+    ASSERT_EQ(CC_ERR_OUT_OF_RANGE, cc_arrayv_add_at(ar, &three, 10));
+
+    const int *buf = cc_arrayv_get_buffer(ar);
+    ASSERT_EQ(1, buf[0]);
+    ASSERT_EQ(2, buf[1]);
+    ASSERT_EQ(3, buf[2]);
+    ASSERT_EQ(4, buf[3]);
+
+    int out;
+    ASSERT_CC_OK(cc_arrayv_remove_at(ar, 0, &out));
+    ASSERT_EQ(1, out);
+    ASSERT_CC_OK(cc_arrayv_remove_last(ar, &out));
+    ASSERT_EQ(4, out);
+    ASSERT_EQ(2, cc_arrayv_size(ar));
+
+    buf = cc_arrayv_get_buffer(ar);
+    ASSERT_EQ(2, buf[0]);
+    ASSERT_EQ(3, buf[1]);
+
+    cc_arrayv_destroy(ar);
+    return true;
+}
+
+bool test_cc_arrayv_sort_filter_contains() {
+    CC_ArrayV *ar;
+    ASSERT_CC_OK(cc_arrayv_new(sizeof(arrayv_rec), &ar));
+
+    int ids[] = {5, 2, 9, 4, 1, 8};
+    for (int i = 0; i < 6; i++) {
+        arrayv_rec r = {ids[i], 0};
+        ASSERT_CC_OK(cc_arrayv_add(ar, &r));
+    }
+
+    cc_arrayv_sort(ar, arrayv_rec_cmp);
+    const arrayv_rec *buf = cc_arrayv_get_buffer(ar);
+    for (int i = 1; i < 6; i++)
+        ASSERT_TRUE(buf[i - 1].id < buf[i].id);
+
+    arrayv_rec key = {9, 0};
+    ASSERT_EQ(1, cc_arrayv_contains_value(ar, &key, arrayv_rec_cmp));
+
+    CC_ArrayV *even;
+    ASSERT_CC_OK(cc_arrayv_filter(ar, arrayv_rec_even, &even));
+    ASSERT_EQ(3, cc_arrayv_size(even));
+    ASSERT_EQ(6, cc_arrayv_size(ar));
+
+    ASSERT_CC_OK(cc_arrayv_filter_mut(ar, arrayv_rec_even));
+    ASSERT_EQ(3, cc_arrayv_size(ar));
+    buf = cc_arrayv_get_buffer(ar);
+    ASSERT_EQ(2, buf[0].id);
+    ASSERT_EQ(4, buf[1].id);
+    ASSERT_EQ(8, buf[2].id);
+
+    cc_arrayv_destroy(even);
+    cc_arrayv_destroy(ar);
+    return true;
+}
+
+bool test_cc_arrayv_iter_remove_add() {
+    CC_ArrayV *ar;
+    ASSERT_CC_OK(cc_arrayv_new(sizeof(int), &ar));
+
+    for (int i = 0; i < 6; i++)
+        ASSERT_CC_OK(cc_arrayv_add(ar, &i));
+
+    /* Drop the odd values and duplicate the even ones */
+    CC_ArrayVIter iter;
+    cc_arrayv_iter_init(&iter, ar);
+    void *e;
+    while (cc_arrayv_iter_next(&iter, &e) != CC_ITER_END) {
+        int v = *(int*) e;
+        if (v % 2) {
+            ASSERT_CC_OK(cc_arrayv_iter_remove(&iter, NULL));
+        } else {
+            ASSERT_CC_OK(cc_arrayv_iter_add(&iter, &v));
+        }
+    }
+
+    int expected[] = {0, 0, 2, 2, 4, 4};
+    ASSERT_EQ(6, cc_arrayv_size(ar));
+    size_t i = 0;
+    CC_ARRAYV_FOREACH(val, ar, {
+        if (*(int*) val != expected[i++])
+            return false;
+    })
+
+    cc_arrayv_destroy(ar);
+    return true;
+}
+
+static int typed_int_cmp(const int *a, const int *b)
+{
+    return (*a > *b) - (*a < *b);
+}
+
+CC_ARRAY_DECLARE(IntArray, int, typed_int_cmp)
+
+bool test_cc_array_typed_add_get_remove() {
+    IntArray ar;
+    ASSERT_CC_OK(IntArray_init(&ar, 2));
+
+    for (int i = 0; i < 50; i++)
+        ASSERT_CC_OK(IntArray_add(&ar, i));
+    ASSERT_EQ(50, IntArray_size(&ar));
+    ASSERT_TRUE(ar.capacity >= 50);
+
+    ASSERT_CC_OK(IntArray_add_at(&ar, -1, 0));
+    int out;
+    ASSERT_CC_OK(IntArray_get_at(&ar, 0, &out));
+    ASSERT_EQ(-1, out);
+    ASSERT_EQ(CC_ERR_OUT_OF_RANGE, IntArray_get_at(&ar, 51, &out));
+
+    ASSERT_CC_OK(IntArray_remove_at(&ar, 1, &out));
+    ASSERT_EQ(0, out);
+    ASSERT_CC_OK(IntArray_remove_last(&ar, &out));
+    ASSERT_EQ(49, out);
+    ASSERT_EQ(49, IntArray_size(&ar));
+    ASSERT_EQ(1, ar.buffer[1]);
+
+    IntArray_destroy(&ar);
+    return true;
+}
+
+bool test_cc_array_typed_sort_iter() {
+    IntArray ar;
+    ASSERT_CC_OK(IntArray_init(&ar, 8));
+
+    /* Enough elements, with duplicates, to go through the partitioning path */
+    unsigned seed = 7;
+    for (int i = 0; i < 1000; i++) {
+        seed = seed * 1103515245 + 12345;
+        ASSERT_CC_OK(IntArray_add(&ar, (int) ((seed >> 16) % 100)));
+    }
+    IntArray_sort(&ar);
+
+    int prev = -1;
+    size_t n = 0;
+    CC_ARRAY_TYPED_FOREACH(IntArray, v, &ar, {
+        if (*v < prev)
+            return false;
+        prev = *v;
+        n++;
+    })
+    ASSERT_EQ(1000, n);
+
+    IntArray_destroy(&ar);
+    return true;
+}
+
+bool test_cc_array_arena_allocator() {
+    CC_Arena *arena;
+    ASSERT_CC_OK(cc_arena_new(1024, &arena));
+
+    CC_ArrayConf conf;
+    cc_array_conf_init(&conf);
+    conf.capacity  = 2;
+    conf.allocator = cc_arena_allocator(arena);
+
+    CC_Array *arrays[20];
+    int values[100];
+    for (int i = 0; i < 20; i++) {
+        ASSERT_CC_OK(cc_array_new_conf(&conf, &arrays[i]));
+        for (int j = 0; j < 100; j++) {
+            values[j] = j;
+            ASSERT_CC_OK(cc_array_add(arrays[i], &values[j]));
+        }
+    }
+    void *e;
+    ASSERT_CC_OK(cc_array_get_at(arrays[19], 99, &e));
+    ASSERT_EQ(&values[99], e);
+    ASSERT_TRUE(cc_arena_used(arena) >= 20 * 100 * sizeof(void*));
+
+    /* Copies inherit the allocator */
+    CC_Array *copy;
+    ASSERT_CC_OK(cc_array_copy_shallow(arrays[0], &copy));
+    ASSERT_EQ(100, cc_array_size(copy));
+
+    /* Everything is released together, without destroying each array */
+    cc_arena_reset(arena);
+    ASSERT_TRUE(cc_arena_used(arena) == 0);
+
+    cc_arena_destroy(arena);
+    return true;
+}
+
+bool test_cc_arena_realloc_in_place() {
+    CC_Arena *arena;
+    ASSERT_CC_OK(cc_arena_new(0, &arena));
+
+    CC_Allocator const *a = cc_arena_allocator(arena);
+    char *p = a->mem_alloc(a->ctx, 16);
+    ASSERT_TRUE(p != NULL);
+    memset(p, 'x', 16);
+
+    /* The latest allocation grows without moving */
+    char *q = a->mem_realloc(a->ctx, p, 256);
+    ASSERT_EQ(p, q);
+    ASSERT_EQ('x', q[15]);
+
+    char *z = a->mem_calloc(a->ctx, 4, 8);
+    for (int i = 0; i < 32; i++)
+        ASSERT_EQ(0, z[i]);
+
+    /* An older allocation has to move, keeping its contents */
+    char *m = a->mem_realloc(a->ctx, q, 512);
+    ASSERT_NEQ(q, m);
+    ASSERT_EQ('x', m[0]);
+
+    size_t used = cc_arena_used(arena);
+    a->mem_free(a->ctx, m);
+    ASSERT_TRUE(cc_arena_used(arena) < used);
+
+    cc_arena_destroy(arena);
+    return true;
+}
+
+static size_t counting_alloc_calls;
+static size_t counting_realloc_calls;
+
+static void *counting_alloc(size_t size)
+{
+    counting_alloc_calls++;
+    return malloc(size);
+}
+
+static void *counting_realloc(void *block, size_t size)
+{
+    counting_realloc_calls++;
+    return realloc(block, size);
+}
+
+bool test_cc_array_expand_uses_realloc() {
+    CC_ArrayConf conf;
+    cc_array_conf_init(&conf);
+    conf.capacity    = 1;
+    conf.mem_alloc   = counting_alloc;
+    conf.mem_realloc = counting_realloc;
+
+    counting_alloc_calls   = 0;
+    counting_realloc_calls = 0;
+
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new_conf(&conf, &a));
+    ASSERT_EQ(1, counting_alloc_calls);
+
+    int v[33];
+    for (int i = 0; i < 33; i++)
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+
+    /* 1 -> 2 -> 4 -> 8 -> 16 -> 32 -> 64, without new buffers */
+    ASSERT_EQ(6, counting_realloc_calls);
+    ASSERT_EQ(1, counting_alloc_calls);
+    ASSERT_EQ(64, cc_array_capacity(a));
+
+    ASSERT_CC_OK(cc_array_trim_capacity(a));
+    ASSERT_EQ(7, counting_realloc_calls);
+    ASSERT_EQ(33, cc_array_capacity(a));
+
+    void *e;
+    ASSERT_CC_OK(cc_array_get_at(a, 32, &e));
+    ASSERT_EQ(&v[32], e);
+
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_expand_without_realloc() {
+    CC_ArrayConf conf;
+    cc_array_conf_init(&conf);
+    conf.capacity    = 1;
+    conf.mem_alloc   = counting_alloc;
+    conf.mem_realloc = NULL;
+
+    counting_alloc_calls   = 0;
+    counting_realloc_calls = 0;
+
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new_conf(&conf, &a));
+
+    int v[4];
+    for (int i = 0; i < 4; i++)
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+
+    /* Falls back to allocating and copying on each expansion */
+    ASSERT_EQ(0, counting_realloc_calls);
+    ASSERT_EQ(3, counting_alloc_calls);
+
+    void *e;
+    ASSERT_CC_OK(cc_array_get_at(a, 0, &e));
+    ASSERT_EQ(&v[0], e);
+
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_mmap_threshold() {
+    CC_ArrayConf conf;
+    cc_array_conf_init(&conf);
+    conf.capacity       = 4;
+    conf.mmap_threshold = 4096;
+
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new_conf(&conf, &a));
+
+    size_t n = 100000;
+    for (size_t i = 0; i < n; i++)
+        ASSERT_CC_OK(cc_array_add(a, (void*) (i + 1)));
+
+    ASSERT_EQ(n, cc_array_size(a));
+    for (size_t i = 0; i < n; i += 997) {
+        void *e;
+        ASSERT_CC_OK(cc_array_get_at(a, i, &e));
+        ASSERT_EQ((void*) (i + 1), e);
+    }
+
+    /* Shrinking and copying a mapped array keep the contents intact */
+    ASSERT_CC_OK(cc_array_remove_at(a, 0, NULL));
+    ASSERT_CC_OK(cc_array_trim_capacity(a));
+    ASSERT_EQ(n - 1, cc_array_capacity(a));
+
+    CC_Array *copy;
+    ASSERT_CC_OK(cc_array_copy_shallow(a, &copy));
+    void *last;
+    ASSERT_CC_OK(cc_array_get_last(copy, &last));
+    ASSERT_EQ((void*) n, last);
+
+    cc_array_remove_all(a);
+    ASSERT_EQ(0, cc_array_size(a));
+    ASSERT_CC_OK(cc_array_add(a, (void*) 7));
+
+    cc_array_destroy(copy);
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_inline_slots() {
+    CC_ArrayConf conf;
+    cc_array_conf_init(&conf);
+    conf.capacity        = 2;
+    conf.inline_capacity = 4;
+    conf.mem_alloc       = counting_alloc;
+
+    counting_alloc_calls = 0;
+
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new_conf(&conf, &a));
+    ASSERT_EQ(4, cc_array_capacity(a));
+
+    int v[6];
+    for (int i = 0; i < 4; i++)
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+
+    /* Only the structure was allocated so far */
+    ASSERT_EQ(0, counting_alloc_calls);
+
+    CC_Array *copy;
+    ASSERT_CC_OK(cc_array_copy_shallow(a, &copy));
+    ASSERT_EQ(0, counting_alloc_calls);
+
+    /* Outgrowing the inline slots spills to the heap */
+    ASSERT_CC_OK(cc_array_add(a, &v[4]));
+    ASSERT_CC_OK(cc_array_add(a, &v[5]));
+    ASSERT_EQ(1, counting_alloc_calls);
+    ASSERT_EQ(8, cc_array_capacity(a));
+
+    void *e;
+    ASSERT_CC_OK(cc_array_get_at(a, 3, &e));
+    ASSERT_EQ(&v[3], e);
+
+    /* Trimming a small enough array moves it back inline */
+    ASSERT_CC_OK(cc_array_remove_last(a, NULL));
+    ASSERT_CC_OK(cc_array_remove_last(a, NULL));
+    ASSERT_CC_OK(cc_array_remove_last(a, NULL));
+    ASSERT_CC_OK(cc_array_trim_capacity(a));
+    ASSERT_EQ(4, cc_array_capacity(a));
+    ASSERT_CC_OK(cc_array_get_last(a, &e));
+    ASSERT_EQ(&v[2], e);
+
+    ASSERT_CC_OK(cc_array_get_last(copy, &e));
+    ASSERT_EQ(&v[3], e);
+
+    cc_array_destroy(copy);
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_new_fixed() {
+    CC_Array *a;
+    ASSERT_EQ(CC_ERR_INVALID_CAPACITY, cc_array_new_fixed(0, &a));
+
+    CC_ArrayConf conf;
+    cc_array_conf_init(&conf);
+    conf.capacity  = 3;
+    conf.mem_alloc = counting_alloc;
+
+    counting_alloc_calls = 0;
+
+    ASSERT_CC_OK(cc_array_new_fixed_conf(&conf, &a));
+    ASSERT_EQ(3, cc_array_capacity(a));
+
+    int v[4];
+    for (int i = 0; i < 3; i++)
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+
+    ASSERT_EQ(CC_ERR_MAX_CAPACITY, cc_array_add(a, &v[3]));
+    ASSERT_EQ(CC_ERR_MAX_CAPACITY, cc_array_add_at(a, &v[3], 0));
+    ASSERT_EQ(3, cc_array_size(a));
+    ASSERT_EQ(0, counting_alloc_calls);
+
+    void *e;
+    ASSERT_CC_OK(cc_array_remove_at(a, 0, &e));
+    ASSERT_EQ(&v[0], e);
+    ASSERT_CC_OK(cc_array_trim_capacity(a));
+    ASSERT_EQ(3, cc_array_capacity(a));
+    ASSERT_CC_OK(cc_array_add(a, &v[3]));
+    ASSERT_CC_OK(cc_array_get_last(a, &e));
+    ASSERT_EQ(&v[3], e);
+
+    cc_array_destroy(a);
+    return true;
+}
+
+static bool keep_below_five(const void *e)
+{
+    return *(const int*) e < 5;
+}
+
+bool test_cc_array_auto_shrink() {
+    CC_ArrayConf conf;
+    cc_array_conf_init(&conf);
+    conf.capacity    = 4;
+    conf.auto_shrink = true;
+
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new_conf(&conf, &a));
+
+    int v[64];
+    for (int i = 0; i < 64; i++) {
+        v[i] = i;
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+    }
+    ASSERT_EQ(64, cc_array_capacity(a));
+
+    while (cc_array_size(a) > 17)
+        ASSERT_CC_OK(cc_array_remove_last(a, NULL));
+    ASSERT_EQ(64, cc_array_capacity(a));
+
+    ASSERT_CC_OK(cc_array_remove_at(a, 0, NULL));
+    ASSERT_EQ(32, cc_array_capacity(a));
+
+    /* Growing back to the new capacity does not expand it again */
+    while (cc_array_size(a) < 32)
+        ASSERT_CC_OK(cc_array_add(a, &v[63]));
+    ASSERT_EQ(32, cc_array_capacity(a));
+
+    ASSERT_CC_OK(cc_array_filter_mut(a, keep_below_five));
+    ASSERT_EQ(4, cc_array_size(a));
+    ASSERT_EQ(8, cc_array_capacity(a));
+
+    void *e;
+    ASSERT_CC_OK(cc_array_get_at(a, 0, &e));
+    ASSERT_EQ(&v[1], e);
+
+    /* Never below the initial capacity */
+    cc_array_remove_all(a);
+    ASSERT_EQ(4, cc_array_capacity(a));
+
+    cc_array_destroy(a);
+    return true;
+}
+
+static size_t grow_once(enum cc_array_growth growth, size_t capacity)
+{
+    CC_ArrayConf conf;
+    cc_array_conf_init(&conf);
+    conf.capacity = capacity;
+    conf.growth   = growth;
+
+    CC_Array *a;
+    if (cc_array_new_conf(&conf, &a) != CC_OK)
+        return 0;
+
+    for (size_t i = 0; i <= capacity; i++)
+        cc_array_add(a, (void*) (i + 1));
+
+    size_t grown = cc_array_capacity(a);
+    cc_array_destroy(a);
+    return grown;
+}
+
+bool test_cc_array_growth_strategies() {
+    ASSERT_EQ(20, grow_once(CC_ARRAY_GROWTH_FACTOR, 10));
+    ASSERT_EQ(20, grow_once(CC_ARRAY_GROWTH_DOUBLE, 10));
+    ASSERT_EQ(15, grow_once(CC_ARRAY_GROWTH_HALF, 10));
+    ASSERT_EQ(2, grow_once(CC_ARRAY_GROWTH_HALF, 1));
+    ASSERT_EQ(26, grow_once(CC_ARRAY_GROWTH_ADDITIVE, 10));
+    ASSERT_EQ(512, grow_once(CC_ARRAY_GROWTH_ADDITIVE, 256));
+
+    /* Size classes never hand out less than doubling would */
+    ASSERT_TRUE(grow_once(CC_ARRAY_GROWTH_SIZE_CLASS, 3) >= 6);
+    ASSERT_TRUE(grow_once(CC_ARRAY_GROWTH_SIZE_CLASS, 1000) >= 2048);
+
+    CC_ArrayConf conf;
+    cc_array_conf_init(&conf);
+    conf.capacity = 1;
+    conf.growth   = CC_ARRAY_GROWTH_SIZE_CLASS;
+
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new_conf(&conf, &a));
+    for (size_t i = 0; i < 5000; i++)
+        ASSERT_CC_OK(cc_array_add(a, (void*) (i + 1)));
+
+    for (size_t i = 0; i < 5000; i++) {
+        void *e;
+        ASSERT_CC_OK(cc_array_get_at(a, i, &e));
+        ASSERT_EQ((void*) (i + 1), e);
+    }
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_reserve_add_all() {
+    CC_ArrayConf conf;
+    cc_array_conf_init(&conf);
+    conf.capacity    = 2;
+    conf.mem_realloc = counting_realloc;
+
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new_conf(&conf, &a));
+
+    ASSERT_CC_OK(cc_array_reserve(a, 100));
+    ASSERT_EQ(100, cc_array_capacity(a));
+    ASSERT_CC_OK(cc_array_reserve(a, 10));
+    ASSERT_EQ(100, cc_array_capacity(a));
+
+    void *src[1000];
+    for (size_t i = 0; i < 1000; i++)
+        src[i] = (void*) (i + 1);
+
+    counting_realloc_calls = 0;
+    ASSERT_CC_OK(cc_array_add(a, src[0]));
+    ASSERT_CC_OK(cc_array_add_all(a, src + 1, 999));
+    ASSERT_EQ(1, counting_realloc_calls);
+    ASSERT_EQ(1000, cc_array_size(a));
+
+    ASSERT_CC_OK(cc_array_add_all(a, src, 0));
+    ASSERT_EQ(1000, cc_array_size(a));
+
+    void *e;
+    ASSERT_CC_OK(cc_array_get_at(a, 999, &e));
+    ASSERT_EQ(src[999], e);
+
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_append_array() {
+    CC_Array *a;
+    CC_Array *b;
+    ASSERT_CC_OK(cc_array_new(&a));
+    ASSERT_CC_OK(cc_array_new(&b));
+
+    int v[20];
+    for (int i = 0; i < 10; i++) {
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+        ASSERT_CC_OK(cc_array_add(b, &v[i + 10]));
+    }
+
+    ASSERT_CC_OK(cc_array_append_array(a, b));
+    ASSERT_EQ(20, cc_array_size(a));
+    ASSERT_EQ(10, cc_array_size(b));
+
+    /* Appending an array to itself doubles its contents */
+    ASSERT_CC_OK(cc_array_append_array(a, a));
+    ASSERT_EQ(40, cc_array_size(a));
+
+    void *e;
+    for (size_t i = 0; i < 40; i++) {
+        ASSERT_CC_OK(cc_array_get_at(a, i, &e));
+        ASSERT_EQ(&v[i % 20], e);
+    }
+
+    CC_Array *f;
+    ASSERT_CC_OK(cc_array_new_fixed(30, &f));
+    ASSERT_EQ(CC_ERR_MAX_CAPACITY, cc_array_append_array(f, a));
+    ASSERT_EQ(0, cc_array_size(f));
+
+    cc_array_destroy(f);
+    cc_array_destroy(b);
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_add_range_at() {
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+
+    int v[10];
+    ASSERT_CC_OK(cc_array_add(a, &v[0]));
+    ASSERT_CC_OK(cc_array_add(a, &v[9]));
+
+    void *mid[] = {&v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7], &v[8]};
+    ASSERT_EQ(CC_ERR_OUT_OF_RANGE, cc_array_add_range_at(a, mid, 8, 3));
+    ASSERT_CC_OK(cc_array_add_range_at(a, mid, 8, 1));
+    ASSERT_EQ(10, cc_array_size(a));
+
+    void *e;
+    for (size_t i = 0; i < 10; i++) {
+        ASSERT_CC_OK(cc_array_get_at(a, i, &e));
+        ASSERT_EQ(&v[i], e);
+    }
+
+    /* Inserting at the end appends */
+    ASSERT_CC_OK(cc_array_add_range_at(a, mid, 2, 10));
+    ASSERT_CC_OK(cc_array_get_last(a, &e));
+    ASSERT_EQ(&v[2], e);
+
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_zip_iter_add_range() {
+    CC_Array *a;
+    CC_Array *b;
+    ASSERT_CC_OK(cc_array_new(&a));
+    ASSERT_CC_OK(cc_array_new(&b));
+
+    int v[4];
+    ASSERT_CC_OK(cc_array_add(a, &v[0]));
+    ASSERT_CC_OK(cc_array_add(a, &v[3]));
+    ASSERT_CC_OK(cc_array_add(b, &v[3]));
+    ASSERT_CC_OK(cc_array_add(b, &v[0]));
+
+    void *src1[] = {&v[1], &v[2]};
+    void *src2[] = {&v[2], &v[1]};
+
+    CC_ArrayZipIter iter;
+    cc_array_zip_iter_init(&iter, a, b);
+    void *e1;
+    void *e2;
+    ASSERT_CC_OK(cc_array_zip_iter_next(&iter, &e1, &e2));
+    ASSERT_CC_OK(cc_array_zip_iter_add_range(&iter, src1, src2, 2));
+
+    /* The iterator continues after the inserted pairs */
+    ASSERT_CC_OK(cc_array_zip_iter_next(&iter, &e1, &e2));
+    ASSERT_EQ(&v[3], e1);
+    ASSERT_EQ(&v[0], e2);
+    ASSERT_EQ(CC_ITER_END, cc_array_zip_iter_next(&iter, &e1, &e2));
+
+    ASSERT_EQ(4, cc_array_size(a));
+    ASSERT_EQ(4, cc_array_size(b));
+    for (size_t i = 0; i < 4; i++) {
+        ASSERT_CC_OK(cc_array_get_at(a, i, &e1));
+        ASSERT_CC_OK(cc_array_get_at(b, i, &e2));
+        ASSERT_EQ(&v[i], e1);
+        ASSERT_EQ(&v[3 - i], e2);
+    }
+
+    cc_array_destroy(a);
+    cc_array_destroy(b);
+    return true;
+}
+
+bool test_cc_array_remove_range() {
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+
+    int v[10];
+    for (int i = 0; i < 10; i++)
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+
+    ASSERT_EQ(CC_ERR_INVALID_RANGE, cc_array_remove_range(a, 4, 3, NULL));
+    ASSERT_EQ(CC_ERR_INVALID_RANGE, cc_array_remove_range(a, 4, 10, NULL));
+
+    void *out[3];
+    ASSERT_CC_OK(cc_array_remove_range(a, 2, 4, out));
+    ASSERT_EQ(7, cc_array_size(a));
+    ASSERT_EQ(&v[2], out[0]);
+    ASSERT_EQ(&v[4], out[2]);
+
+    void *e;
+    ASSERT_CC_OK(cc_array_get_at(a, 2, &e));
+    ASSERT_EQ(&v[5], e);
+
+    /* Removing the tail and then everything else */
+    ASSERT_CC_OK(cc_array_remove_range(a, 5, 6, NULL));
+    ASSERT_CC_OK(cc_array_get_last(a, &e));
+    ASSERT_EQ(&v[7], e);
+    ASSERT_CC_OK(cc_array_remove_range(a, 0, 4, NULL));
+    ASSERT_EQ(0, cc_array_size(a));
+
+    cc_array_destroy(a);
+    return true;
+}
+
+static size_t removed_count;
+
+static void count_removed(void *e)
+{
+    (void) e;
+    removed_count++;
+}
+
+bool test_cc_array_remove_indices() {
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+
+    int v[100];
+    for (int i = 0; i < 100; i++)
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+
+    size_t unsorted[] = {3, 1};
+    size_t outside[]  = {1, 100};
+    ASSERT_EQ(CC_ERR_INVALID_RANGE, cc_array_remove_indices(a, unsorted, 2, NULL));
+    ASSERT_EQ(CC_ERR_OUT_OF_RANGE, cc_array_remove_indices(a, outside, 2, NULL));
+    ASSERT_EQ(100, cc_array_size(a));
+
+    /* Remove every element whose index is a multiple of three */
+    size_t idx[34];
+    for (size_t i = 0; i < 34; i++)
+        idx[i] = i * 3;
+
+    removed_count = 0;
+    ASSERT_CC_OK(cc_array_remove_indices(a, idx, 34, count_removed));
+    ASSERT_EQ(34, removed_count);
+    ASSERT_EQ(66, cc_array_size(a));
+
+    size_t i = 0;
+    CC_ARRAY_FOREACH(e, a, {
+        if (e != &v[i / 2 * 3 + 1 + i % 2])
+            return false;
+        i++;
+    })
+
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_remove_indices_unsorted() {
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+
+    int v[200];
+    for (int i = 0; i < 200; i++)
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+
+    size_t idx[] = {199, 0, 64, 63, 64, 130};
+    size_t outside[] = {5, 200};
+    ASSERT_EQ(CC_ERR_OUT_OF_RANGE, cc_array_remove_indices_unsorted(a, outside, 2, NULL));
+
+    removed_count = 0;
+    ASSERT_CC_OK(cc_array_remove_indices_unsorted(a, idx, 6, count_removed));
+    ASSERT_EQ(5, removed_count);
+    ASSERT_EQ(195, cc_array_size(a));
+
+    void *e;
+    ASSERT_CC_OK(cc_array_get_at(a, 0, &e));
+    ASSERT_EQ(&v[1], e);
+    ASSERT_CC_OK(cc_array_get_at(a, 62, &e));
+    ASSERT_EQ(&v[65], e);
+    ASSERT_CC_OK(cc_array_get_last(a, &e));
+    ASSERT_EQ(&v[198], e);
+
+    cc_array_destroy(a);
+    return true;
+}
+
+static int slice_int_cmp(const void *a, const void *b)
+{
+    int x = **(int* const*) a;
+    int y = **(int* const*) b;
+    return (x > y) - (x < y);
+}
+
+bool test_cc_array_slice() {
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+
+    int v[10] = {9, 8, 7, 6, 5, 4, 3, 2, 1, 0};
+    for (int i = 0; i < 10; i++)
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+
+    CC_ArraySlice s;
+    ASSERT_EQ(CC_ERR_INVALID_RANGE, cc_array_slice(a, 5, 4, &s));
+    ASSERT_EQ(CC_ERR_INVALID_RANGE, cc_array_slice(a, 5, 10, &s));
+    ASSERT_CC_OK(cc_array_slice(a, 2, 5, &s));
+    ASSERT_EQ(4, cc_array_slice_size(&s));
+
+    void *e;
+    ASSERT_CC_OK(cc_array_slice_get_at(&s, 0, &e));
+    ASSERT_EQ(&v[2], e);
+    ASSERT_EQ(CC_ERR_OUT_OF_RANGE, cc_array_slice_get_at(&s, 4, &e));
+
+    ASSERT_EQ(1, cc_array_slice_contains(&s, &v[5]));
+    ASSERT_EQ(0, cc_array_slice_contains(&s, &v[6]));
+
+    int result = 0;
+    cc_array_slice_reduce(&s, sum_fn, &result);
+    ASSERT_EQ(7 + 6 + 5 + 4, result);
+
+    /* Sorting the slice reorders only that range of the array */
+    cc_array_slice_sort(&s, slice_int_cmp);
+    int expected[] = {9, 8, 4, 5, 6, 7, 3, 2, 1, 0};
+    size_t i = 0;
+    CC_ARRAY_FOREACH(val, a, {
+        if (*(int*) val != expected[i++])
+            return false;
+    })
+
+    i = 0;
+    CC_ARRAY_SLICE_FOREACH(val, &s, {
+        if (*(int*) val != expected[2 + i++])
+            return false;
+    })
+    ASSERT_EQ(4, i);
+
+    /* The slice follows the array when its buffer moves */
+    for (int j = 0; j < 100; j++)
+        ASSERT_CC_OK(cc_array_add(a, &v[0]));
+    cc_array_slice_map(&s, increment);
+    ASSERT_CC_OK(cc_array_slice_get_at(&s, 3, &e));
+    ASSERT_EQ(8, *(int*) e);
+
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_copy_cow() {
+    CC_ArrayConf conf;
+    cc_array_conf_init(&conf);
+    conf.mem_alloc = counting_alloc;
+
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new_conf(&conf, &a));
+
+    int v[20];
+    for (int i = 0; i < 10; i++)
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+
+    counting_alloc_calls = 0;
+
+    CC_Array *snap;
+    CC_Array *snap2;
+    ASSERT_CC_OK(cc_array_copy_cow(a, &snap));
+    ASSERT_CC_OK(cc_array_copy_cow(snap, &snap2));
+
+    /* Only the reference count was allocated, the buffer is shared */
+    ASSERT_EQ(1, counting_alloc_calls);
+    ASSERT_EQ(cc_array_get_buffer(a), cc_array_get_buffer(snap));
+    ASSERT_EQ(cc_array_get_buffer(a), cc_array_get_buffer(snap2));
+
+    /* The first modification gives the array its own buffer */
+    ASSERT_CC_OK(cc_array_replace_at(a, &v[15], 0, NULL));
+    ASSERT_NEQ(cc_array_get_buffer(a), cc_array_get_buffer(snap));
+
+    void *e;
+    ASSERT_CC_OK(cc_array_get_at(snap, 0, &e));
+    ASSERT_EQ(&v[0], e);
+    ASSERT_CC_OK(cc_array_get_at(a, 0, &e));
+    ASSERT_EQ(&v[15], e);
+
+    cc_array_reverse(snap2);
+    ASSERT_CC_OK(cc_array_get_at(snap2, 0, &e));
+    ASSERT_EQ(&v[9], e);
+    ASSERT_CC_OK(cc_array_get_at(snap, 0, &e));
+    ASSERT_EQ(&v[0], e);
+
+    /* The last holder takes over the buffer without copying it */
+    const void * const *buff = cc_array_get_buffer(snap);
+    counting_alloc_calls = 0;
+    for (int i = 10; i < 16; i++)
+        ASSERT_CC_OK(cc_array_add(snap, &v[i]));
+    ASSERT_EQ(0, counting_alloc_calls);
+    ASSERT_EQ(buff, cc_array_get_buffer(snap));
+    ASSERT_EQ(16, cc_array_size(snap));
+    ASSERT_EQ(10, cc_array_size(a));
+
+    cc_array_destroy(snap2);
+    cc_array_destroy(snap);
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_copy_cow_destroy_original() {
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+
+    int v[40];
+    for (int i = 0; i < 5; i++)
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+
+    CC_Array *snap;
+    ASSERT_CC_OK(cc_array_copy_cow(a, &snap));
+    cc_array_destroy(a);
+
+    /* Growing a buffer that is no longer shared */
+    for (int i = 5; i < 40; i++)
+        ASSERT_CC_OK(cc_array_add(snap, &v[i]));
+
+    CC_Array *snap2;
+    ASSERT_CC_OK(cc_array_copy_cow(snap, &snap2));
+    ASSERT_CC_OK(cc_array_remove_range(snap, 0, 29, NULL));
+    cc_array_remove_all(snap2);
+
+    void *e;
+    ASSERT_CC_OK(cc_array_get_at(snap, 0, &e));
+    ASSERT_EQ(&v[30], e);
+    ASSERT_EQ(10, cc_array_size(snap));
+    ASSERT_EQ(0, cc_array_size(snap2));
+
+    cc_array_destroy(snap2);
+    cc_array_destroy(snap);
+    return true;
+}
+
+static bool keep_even_value(const void *e)
+{
+    return *(const int*) e % 2 == 0;
+}
+
+bool test_cc_array_remove_unordered() {
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+
+    int v[5] = {0, 1, 2, 3, 4};
+    for (int i = 0; i < 5; i++)
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+
+    void *e;
+    ASSERT_CC_OK(cc_array_remove_at_unordered(a, 1, &e));
+    ASSERT_EQ(&v[1], e);
+    ASSERT_CC_OK(cc_array_get_at(a, 1, &e));
+    ASSERT_EQ(&v[4], e);
+    ASSERT_EQ(4, cc_array_size(a));
+
+    ASSERT_EQ(CC_ERR_VALUE_NOT_FOUND, cc_array_remove_unordered(a, &v[1], NULL));
+    ASSERT_CC_OK(cc_array_remove_unordered(a, &v[3], NULL));
+    ASSERT_CC_OK(cc_array_get_last(a, &e));
+    ASSERT_EQ(&v[2], e);
+
+    /* Removing the last element leaves nothing to swap in */
+    ASSERT_CC_OK(cc_array_remove_at_unordered(a, 2, &e));
+    ASSERT_EQ(&v[2], e);
+    ASSERT_EQ(2, cc_array_size(a));
+    ASSERT_EQ(CC_ERR_OUT_OF_RANGE, cc_array_remove_at_unordered(a, 2, NULL));
+
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_iter_remove_unordered() {
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+
+    int v[10];
+    for (int i = 0; i < 10; i++) {
+        v[i] = i;
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+    }
+
+    /* Every element is visited exactly once despite the swaps */
+    size_t visited = 0;
+    CC_ArrayIter iter;
+    cc_array_iter_init(&iter, a);
+    void *e;
+    while (cc_array_iter_next(&iter, &e) != CC_ITER_END) {
+        visited++;
+        if (*(int*) e % 2)
+            ASSERT_CC_OK(cc_array_iter_remove_unordered(&iter, NULL));
+    }
+    ASSERT_EQ(10, visited);
+    ASSERT_EQ(5, cc_array_size(a));
+    CC_ARRAY_FOREACH(val, a, {
+        if (*(int*) val % 2)
+            return false;
+    })
+
+    for (int i = 0; i < 10; i += 2)
+        ASSERT_CC_OK(cc_array_add(a, &v[i + 1]));
+
+    ASSERT_CC_OK(cc_array_filter_mut_unordered(a, keep_even_value));
+    ASSERT_EQ(5, cc_array_size(a));
+    for (int i = 0; i < 10; i += 2)
+        ASSERT_EQ(1, cc_array_contains(a, &v[i]));
+
+    cc_array_destroy(a);
+    return true;
+}
+
+static bool below_fifty(const void *e)
+{
+    return *(const int*) e < 50;
+}
+
+bool test_cc_array_filter_mut_alternating() {
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+
+    int v[1000];
+    for (int i = 0; i < 1000; i++) {
+        v[i] = i;
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+    }
+
+    ASSERT_CC_OK(cc_array_filter_mut(a, keep_even_value));
+    ASSERT_EQ(500, cc_array_size(a));
+
+    size_t i = 0;
+    CC_ARRAY_FOREACH(e, a, {
+        if (e != &v[i])
+            return false;
+        i += 2;
+    })
+
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_partition() {
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+
+    int v[100];
+    for (int i = 0; i < 100; i++) {
+        v[i] = (i * 37) % 100;
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+    }
+
+    size_t split;
+    ASSERT_CC_OK(cc_array_partition(a, below_fifty, &split));
+    ASSERT_EQ(50, split);
+    ASSERT_EQ(100, cc_array_size(a));
+
+    for (size_t i = 0; i < 100; i++) {
+        void *e;
+        ASSERT_CC_OK(cc_array_get_at(a, i, &e));
+        ASSERT_EQ(i < split, below_fifty(e));
+    }
+
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_partition_stable() {
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+
+    size_t split;
+    ASSERT_CC_OK(cc_array_partition_stable(a, below_fifty, &split));
+    ASSERT_EQ(0, split);
+
+    int v[101];
+    for (int i = 0; i < 101; i++) {
+        v[i] = (i * 37) % 101;
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+    }
+
+    ASSERT_CC_OK(cc_array_partition_stable(a, below_fifty, &split));
+    ASSERT_EQ(50, split);
+
+    /* Both parts keep the original relative order of their elements */
+    void *prev = NULL;
+    for (size_t i = 0; i < 101; i++) {
+        void *e;
+        ASSERT_CC_OK(cc_array_get_at(a, i, &e));
+        ASSERT_EQ(i < split, below_fifty(e));
+        if (i != split && prev)
+            ASSERT_TRUE((int*) prev < (int*) e);
+        prev = e;
+    }
+
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_filter_into() {
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+
+    int v[100];
+    for (int i = 0; i < 100; i++) {
+        v[i] = i;
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+    }
+    ASSERT_EQ(50, cc_array_count_if(a, below_fifty));
+
+    CC_ArrayConf conf;
+    cc_array_conf_init(&conf);
+    conf.capacity  = 1;
+    conf.mem_alloc = counting_alloc;
+
+    CC_Array *dst;
+    ASSERT_CC_OK(cc_array_new_conf(&conf, &dst));
+    ASSERT_CC_OK(cc_array_reserve(dst, cc_array_count_if(a, below_fifty)));
+
+    /* Steady state filtering reuses the destination buffer */
+    counting_alloc_calls = 0;
+    for (int round = 0; round < 3; round++) {
+        cc_array_remove_all(dst);
+        ASSERT_CC_OK(cc_array_filter_into(a, below_fifty, dst));
+        ASSERT_EQ(50, cc_array_size(dst));
+    }
+    ASSERT_EQ(0, counting_alloc_calls);
+
+    void *e;
+    ASSERT_CC_OK(cc_array_get_last(dst, &e));
+    ASSERT_EQ(&v[49], e);
+
+    /* Appending to the existing contents, including the source itself */
+    ASSERT_CC_OK(cc_array_filter_into(a, keep_even_value, dst));
+    ASSERT_EQ(100, cc_array_size(dst));
+    ASSERT_CC_OK(cc_array_filter_into(a, below_fifty, a));
+    ASSERT_EQ(150, cc_array_size(a));
+    ASSERT_CC_OK(cc_array_get_last(a, &e));
+    ASSERT_EQ(&v[49], e);
+
+    CC_Array *fixed;
+    ASSERT_CC_OK(cc_array_new_fixed(10, &fixed));
+    ASSERT_EQ(CC_ERR_MAX_CAPACITY, cc_array_filter_into(a, below_fifty, fixed));
+    ASSERT_EQ(0, cc_array_size(fixed));
+
+    cc_array_destroy(fixed);
+    cc_array_destroy(dst);
+    cc_array_destroy(a);
+    return true;
+}
+
+static size_t linear_count(CC_Array *a, void *element)
+{
+    size_t n = 0;
+    CC_ARRAY_FOREACH(e, a, {
+        if (e == element)
+            n++;
+    })
+    return n;
+}
+
+bool test_cc_array_index() {
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+
+    static int v[2000];
+    for (int i = 0; i < 1000; i++)
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+
+    ASSERT_CC_OK(cc_array_index_enable(a));
+
+    /* Appends with duplicates and a NULL element */
+    for (int i = 0; i < 2000; i += 2)
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+    ASSERT_CC_OK(cc_array_add(a, NULL));
+
+    ASSERT_EQ(2, cc_array_contains(a, &v[10]));
+    ASSERT_EQ(1, cc_array_contains(a, &v[11]));
+    ASSERT_EQ(1, cc_array_contains(a, &v[1500]));
+    ASSERT_EQ(0, cc_array_contains(a, &v[1501]));
+    ASSERT_EQ(1, cc_array_contains(a, NULL));
+
+    size_t idx;
+    ASSERT_CC_OK(cc_array_index_of(a, &v[1500], &idx));
+    ASSERT_EQ(1750, idx);
+    ASSERT_EQ(CC_ERR_OUT_OF_RANGE, cc_array_index_of(a, &v[1501], &idx));
+
+    /* Unordered removals keep the index up to date */
+    ASSERT_CC_OK(cc_array_remove_unordered(a, &v[10], NULL));
+    ASSERT_CC_OK(cc_array_index_of(a, &v[10], &idx));
+    ASSERT_EQ(1005, idx);
+    ASSERT_CC_OK(cc_array_index_of(a, NULL, &idx));
+    ASSERT_EQ(10, idx);
+    ASSERT_CC_OK(cc_array_remove_last(a, NULL));
+
+    /* Ordered removals and reordering are picked up by the next lookup */
+    ASSERT_CC_OK(cc_array_remove(a, &v[0], NULL));
+    cc_array_reverse(a);
+    for (int i = 0; i < 2000; i += 7) {
+        ASSERT_EQ(linear_count(a, &v[i]), cc_array_contains(a, &v[i]));
+        if (cc_array_index_of(a, &v[i], &idx) == CC_OK) {
+            void *e;
+            ASSERT_CC_OK(cc_array_get_at(a, idx, &e));
+            ASSERT_EQ(&v[i], e);
+        }
+    }
+
+    cc_array_remove_all(a);
+    ASSERT_EQ(0, cc_array_contains(a, &v[2]));
+    ASSERT_CC_OK(cc_array_add(a, &v[2]));
+    ASSERT_EQ(1, cc_array_contains(a, &v[2]));
+
+    cc_array_index_disable(a);
+    ASSERT_EQ(1, cc_array_contains(a, &v[2]));
+
+    cc_array_destroy(a);
+    return true;
+}
+
+static int sorted_value_cmp(const void *a, const void *b)
+{
+    int x = *(const int*) a;
+    int y = *(const int*) b;
+    return (x > y) - (x < y);
+}
+
+bool test_cc_array_bsearch_bounds() {
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+
+    /* 0 1 1 1 3 5 5 7 */
+    static int v[] = { 0, 1, 1, 1, 3, 5, 5, 7 };
+    for (int i = 0; i < 8; i++)
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+
+    int key = 1;
+    size_t idx;
+    ASSERT_CC_OK(cc_array_bsearch(a, &key, sorted_value_cmp, &idx));
+    ASSERT_EQ(1, idx);
+    ASSERT_EQ(1, cc_array_lower_bound(a, &key, sorted_value_cmp));
+    ASSERT_EQ(4, cc_array_upper_bound(a, &key, sorted_value_cmp));
+    ASSERT_EQ(3, cc_array_equal_range(a, &key, sorted_value_cmp, &idx));
+    ASSERT_EQ(1, idx);
+
+    key = 4;
+    ASSERT_EQ(CC_ERR_VALUE_NOT_FOUND, cc_array_bsearch(a, &key, sorted_value_cmp, &idx));
+    ASSERT_EQ(0, cc_array_equal_range(a, &key, sorted_value_cmp, &idx));
+    ASSERT_EQ(5, idx);
+
+    key = -1;
+    ASSERT_EQ(0, cc_array_lower_bound(a, &key, sorted_value_cmp));
+    key = 9;
+    ASSERT_EQ(8, cc_array_upper_bound(a, &key, sorted_value_cmp));
+
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_add_sorted() {
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+    cc_array_set_sorted(a, sorted_value_cmp);
+
+    static int v[] = { 5, 3, 9, 3, 0, 7, 5, 1 };
+    for (int i = 0; i < 8; i++)
+        ASSERT_CC_OK(cc_array_add_sorted(a, &v[i], sorted_value_cmp));
+
+    int *prev = NULL;
+    CC_ARRAY_FOREACH(e, a, {
+        if (prev)
+            ASSERT_TRUE(*prev <= *(int*) e);
+        prev = e;
+    })
+
+    /* Equal elements keep their insertion order */
+    void *e;
+    ASSERT_CC_OK(cc_array_get_at(a, 2, &e));
+    ASSERT_EQ(&v[1], e);
+    ASSERT_CC_OK(cc_array_get_at(a, 3, &e));
+    ASSERT_EQ(&v[3], e);
+
+    /* The binary search path counts the same as the linear scan */
+    int key = 5;
+    ASSERT_EQ(2, cc_array_contains_value(a, &key, sorted_value_cmp));
+
+    ASSERT_CC_OK(cc_array_remove_at(a, 0, NULL));
+    ASSERT_EQ(2, cc_array_contains_value(a, &key, sorted_value_cmp));
+
+    /* An unordered append clears the mark and the scan is used again */
+    ASSERT_CC_OK(cc_array_add(a, &v[0]));
+    ASSERT_EQ(3, cc_array_contains_value(a, &key, sorted_value_cmp));
+
+    cc_array_destroy(a);
+    return true;
+}
+
+static int sort_value_cmp(const void *a, const void *b)
+{
+    int x = **(int* const*) a;
+    int y = **(int* const*) b;
+    return (x > y) - (x < y);
+}
+
+static bool sort_pattern_ok(int *v, size_t n)
+{
+    CC_Array *a;
+    if (cc_array_new(&a) != CC_OK)
+        return false;
+
+    long sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        cc_array_add(a, &v[i]);
+        sum += v[i];
+    }
+    cc_array_sort(a, sort_value_cmp);
+
+    bool ok = cc_array_size(a) == n;
+    int *prev = NULL;
+    CC_ARRAY_FOREACH(e, a, {
+        if (prev && *prev > *(int*) e)
+            ok = false;
+        sum -= *(int*) e;
+        prev = e;
+    })
+    cc_array_destroy(a);
+    return ok && sum == 0;
+}
+
+bool test_cc_array_sort_patterns() {
+    enum { N = 5000 };
+    static int v[N];
+
+    for (size_t n = 0; n <= N; n = n ? n * 3 : 1) {
+        for (size_t i = 0; i < n; i++)
+            v[i] = (int) i;
+        ASSERT_TRUE(sort_pattern_ok(v, n));
+
+        for (size_t i = 0; i < n; i++)
+            v[i] = (int) (n - i);
+        ASSERT_TRUE(sort_pattern_ok(v, n));
+
+        for (size_t i = 0; i < n; i++)
+            v[i] = 7;
+        ASSERT_TRUE(sort_pattern_ok(v, n));
+
+        for (size_t i = 0; i < n; i++)
+            v[i] = (int) (i % 2 ? i : n - i);
+        ASSERT_TRUE(sort_pattern_ok(v, n));
+
+        /* Organ pipe, sawtooth and few distinct values */
+        for (size_t i = 0; i < n; i++)
+            v[i] = (int) (i < n / 2 ? i : n - i);
+        ASSERT_TRUE(sort_pattern_ok(v, n));
+
+        for (size_t i = 0; i < n; i++)
+            v[i] = (int) (i % 64);
+        ASSERT_TRUE(sort_pattern_ok(v, n));
+
+        unsigned seed = 12345;
+        for (size_t i = 0; i < n; i++) {
+            seed = seed * 1103515245 + 12345;
+            v[i] = (int) ((seed >> 16) % 5);
+        }
+        ASSERT_TRUE(sort_pattern_ok(v, n));
+
+        for (size_t i = 0; i < n; i++) {
+            seed = seed * 1103515245 + 12345;
+            v[i] = (int) (seed >> 8);
+        }
+        ASSERT_TRUE(sort_pattern_ok(v, n));
+    }
+    return true;
+}
+
+static int sort_long_cmp(const long *a, const long *b)
+{
+    return (*a > *b) - (*a < *b);
+}
+
+CC_SORT_DECLARE(sort_longs, long, sort_long_cmp)
+
+bool test_cc_sort_declare() {
+    enum { N = 3000 };
+    static long v[N];
+
+    unsigned seed = 99;
+    for (size_t i = 0; i < N; i++) {
+        seed = seed * 1103515245 + 12345;
+        v[i] = (long) (seed >> 4) % 1000 - 500;
+    }
+    sort_longs(v, N);
+    for (size_t i = 1; i < N; i++)
+        ASSERT_TRUE(v[i - 1] <= v[i]);
+
+    /* Reverse sorted input goes through the already partitioned path */
+    for (size_t i = 0; i < N; i++)
+        v[i] = (long) (N - i);
+    sort_longs(v, N);
+    for (size_t i = 0; i < N; i++)
+        ASSERT_EQ((long) i + 1, v[i]);
+
+    return true;
+}
+
+typedef struct {
+    int key;
+    size_t seq;
+} stable_rec;
+
+static int stable_rec_cmp(const void *a, const void *b)
+{
+    int x = (*(stable_rec* const*) a)->key;
+    int y = (*(stable_rec* const*) b)->key;
+    return (x > y) - (x < y);
+}
+
+static bool stable_sorted(CC_Array *a, size_t n)
+{
+    stable_rec *prev = NULL;
+    size_t count = 0;
+    CC_ARRAY_FOREACH(e, a, {
+        stable_rec *r = e;
+        if (prev && (prev->key > r->key || (prev->key == r->key && prev->seq > r->seq)))
+            return false;
+        prev = r;
+        count++;
+    })
+    return count == n;
+}
+
+bool test_cc_array_sort_stable() {
+    enum { N = 20000 };
+    static stable_rec v[N];
+
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+
+    /* Random keys with many duplicates */
+    unsigned seed = 7;
+    for (size_t i = 0; i < N; i++) {
+        seed = seed * 1103515245 + 12345;
+        v[i].key = (int) ((seed >> 16) % 100);
+        v[i].seq = i;
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+    }
+    ASSERT_CC_OK(cc_array_sort_stable(a, stable_rec_cmp));
+    ASSERT_TRUE(stable_sorted(a, N));
+
+    /* Concatenated sorted and descending runs of different lengths, which
+     * exercise both merge directions and galloping */
+    cc_array_remove_all(a);
+    size_t i = 0;
+    for (size_t run = 1; i < N; run = run * 2 + 3) {
+        for (size_t j = 0; j < run && i < N; j++, i++) {
+            v[i].key = (int) (run % 2 ? j : run - j) / 2;
+            v[i].seq = i;
+            ASSERT_CC_OK(cc_array_add(a, &v[i]));
+        }
+    }
+    ASSERT_CC_OK(cc_array_sort_stable(a, stable_rec_cmp));
+    ASSERT_TRUE(stable_sorted(a, N));
+
+    /* Sorting again is a single run */
+    ASSERT_CC_OK(cc_array_sort_stable(a, stable_rec_cmp));
+    ASSERT_TRUE(stable_sorted(a, N));
+
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_sort_stable_scratch() {
+    enum { N = 4000 };
+    static stable_rec v[N];
+    static void *scratch[N / 2];
+
+    CC_ArrayConf conf;
+    cc_array_conf_init(&conf);
+    conf.mem_alloc = counting_alloc;
+
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new_conf(&conf, &a));
+
+    /* Two interleaving sorted halves */
+    for (size_t i = 0; i < N; i++) {
+        v[i].key = (int) (i < N / 2 ? 2 * i : 2 * (i - N / 2) + 1) / 3;
+        v[i].seq = i;
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+    }
+
+    size_t allocs = counting_alloc_calls;
+    ASSERT_CC_OK(cc_array_sort_stable_scratch(a, stable_rec_cmp, scratch, N / 2));
+    ASSERT_EQ(allocs, counting_alloc_calls);
+    ASSERT_TRUE(stable_sorted(a, N));
+
+    /* Too small a scratch buffer is replaced with an allocated one */
+    for (size_t i = 0; i < N; i++)
+        cc_array_replace_at(a, &v[i], i, NULL);
+    ASSERT_CC_OK(cc_array_sort_stable_scratch(a, stable_rec_cmp, scratch, 4));
+    ASSERT_EQ(allocs + 1, counting_alloc_calls);
+    ASSERT_TRUE(stable_sorted(a, N));
+
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_sort_parallel() {
+    enum { N = 300000 };
+    static int v[N];
+
+    /* Shuffled distinct values, so the comparator is a total order */
+    unsigned seed = 2024;
+    for (size_t i = 0; i < N; i++)
+        v[i] = (int) i;
+    for (size_t i = N - 1; i > 0; i--) {
+        seed = seed * 1103515245 + 12345;
+        size_t j = (seed >> 8) % (i + 1);
+        int tmp  = v[i];
+        v[i] = v[j];
+        v[j] = tmp;
+    }
+
+    CC_Array *serial;
+    ASSERT_CC_OK(cc_array_new(&serial));
+    for (size_t i = 0; i < N; i++)
+        ASSERT_CC_OK(cc_array_add(serial, &v[i]));
+
+    CC_Array *copy;
+    ASSERT_CC_OK(cc_array_copy_shallow(serial, &copy));
+    cc_array_sort(serial, sort_value_cmp);
+
+    /* An odd, an even and the default number of threads */
+    size_t threads[] = { 3, 4, 0 };
+    for (size_t t = 0; t < 3; t++) {
+        CC_Array *par;
+        ASSERT_CC_OK(cc_array_copy_shallow(copy, &par));
+        ASSERT_CC_OK(cc_array_sort_parallel(par, sort_value_cmp, threads[t]));
+
+        for (size_t i = 0; i < N; i++) {
+            void *e1;
+            void *e2;
+            cc_array_get_at(serial, i, &e1);
+            cc_array_get_at(par, i, &e2);
+            ASSERT_EQ(e1, e2);
+        }
+        cc_array_destroy(par);
+    }
+
+    /* Small arrays take the serial path */
+    int w[] = { 3, 1, 2 };
+    CC_Array *small;
+    ASSERT_CC_OK(cc_array_new(&small));
+    for (size_t i = 0; i < 3; i++)
+        ASSERT_CC_OK(cc_array_add(small, &w[i]));
+    ASSERT_CC_OK(cc_array_sort_parallel(small, sort_value_cmp, 8));
+
+    void *e;
+    cc_array_get_at(small, 0, &e);
+    ASSERT_EQ(&w[1], e);
+    cc_array_get_at(small, 2, &e);
+    ASSERT_EQ(&w[0], e);
+
+    cc_array_destroy(small);
+    cc_array_destroy(copy);
+    cc_array_destroy(serial);
+    return true;
+}
+
+typedef struct {
+    uint64_t key;
+    size_t   seq;
+} keyed_rec;
+
+static uint64_t keyed_rec_key(const void *e)
+{
+    return ((keyed_rec const*) e)->key;
+}
+
+static bool keyed_sorted(CC_Array *a, size_t n)
+{
+    keyed_rec *prev = NULL;
+    size_t count = 0;
+    CC_ARRAY_FOREACH(e, a, {
+        keyed_rec *r = e;
+        if (prev && (prev->key > r->key || (prev->key == r->key && prev->seq > r->seq)))
+            return false;
+        prev = r;
+        count++;
+    })
+    return count == n;
+}
+
+bool test_cc_array_sort_by_key() {
+    enum { N = 10000 };
+    static keyed_rec v[N];
+
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+
+    /* Full 64-bit keys, with a few of them repeated */
+    uint64_t seed = 1;
+    for (size_t i = 0; i < N; i++) {
+        seed = seed * 6364136223846793005u + 1442695040888963407u;
+        v[i].key = i % 10 ? seed : v[i / 2].key;
+        v[i].seq = i;
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+    }
+    ASSERT_CC_OK(cc_array_sort_by_key(a, keyed_rec_key));
+    ASSERT_TRUE(keyed_sorted(a, N));
+
+    /* Small keys skip the passes over the high bytes and stay stable */
+    cc_array_remove_all(a);
+    for (size_t i = 0; i < N; i++) {
+        v[i].key = (N - i) % 300;
+        v[i].seq = i;
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+    }
+    ASSERT_CC_OK(cc_array_sort_by_key(a, keyed_rec_key));
+    ASSERT_TRUE(keyed_sorted(a, N));
+
+    /* All keys equal leaves the order as it was */
+    cc_array_remove_all(a);
+    for (size_t i = 0; i < N; i++) {
+        v[i].key = 42;
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+    }
+    ASSERT_CC_OK(cc_array_sort_by_key(a, keyed_rec_key));
+    size_t i = 0;
+    CC_ARRAY_FOREACH(e, a, {
+        ASSERT_EQ(&v[i++], e);
+    })
+
+    cc_array_destroy(a);
+    return true;
+}
+
+static int sort_value_desc(const void *a, const void *b)
+{
+    return sort_value_cmp(b, a);
+}
+
+static int *select_value_at(CC_Array *a, size_t i)
+{
+    void *e;
+    cc_array_get_at(a, i, &e);
+    return e;
+}
+
+bool test_cc_array_select_nth() {
+    enum { N = 5000 };
+    static int v[N];
+
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+
+    unsigned seed = 3;
+    for (size_t i = 0; i < N; i++) {
+        seed = seed * 1103515245 + 12345;
+        v[i] = (int) ((seed >> 16) % 1000);
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+    }
+
+    CC_Array *sorted;
+    ASSERT_CC_OK(cc_array_copy_shallow(a, &sorted));
+    cc_array_sort(sorted, sort_value_cmp);
+
+    size_t nth[] = { 0, 1, 17, N / 2, N - 2, N - 1 };
+    for (size_t t = 0; t < sizeof(nth) / sizeof(nth[0]); t++) {
+        ASSERT_CC_OK(cc_array_select_nth(a, nth[t], sort_value_cmp));
+
+        int x = *select_value_at(a, nth[t]);
+        ASSERT_EQ(*select_value_at(sorted, nth[t]), x);
+        for (size_t i = 0; i < N; i++) {
+            if (i < nth[t])
+                ASSERT_TRUE(*select_value_at(a, i) <= x);
+            if (i > nth[t])
+                ASSERT_TRUE(*select_value_at(a, i) >= x);
+        }
+    }
+    ASSERT_EQ(CC_ERR_OUT_OF_RANGE, cc_array_select_nth(a, N, sort_value_cmp));
+
+    /* Many equal elements: 3333 zeros followed by ones */
+    for (size_t i = 0; i < N; i++)
+        v[i] = i % 3 == 0;
+    ASSERT_CC_OK(cc_array_select_nth(a, 3333, sort_value_cmp));
+    ASSERT_EQ(1, *select_value_at(a, 3333));
+    for (size_t i = 0; i < 3333; i++)
+        ASSERT_EQ(0, *select_value_at(a, i));
+
+    cc_array_destroy(sorted);
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_partial_sort() {
+    enum { N = 3000, K = 100 };
+    static int v[N];
+
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+
+    for (size_t i = 0; i < N; i++) {
+        v[i] = (int) ((i * 7919) % N);
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+    }
+
+    ASSERT_CC_OK(cc_array_partial_sort(a, K, sort_value_cmp));
+    for (size_t i = 0; i < K; i++)
+        ASSERT_EQ((int) i, *select_value_at(a, i));
+    ASSERT_EQ(N, cc_array_size(a));
+
+    ASSERT_CC_OK(cc_array_partial_sort(a, 0, sort_value_cmp));
+    ASSERT_EQ(CC_ERR_OUT_OF_RANGE, cc_array_partial_sort(a, N + 1, sort_value_cmp));
+
+    ASSERT_CC_OK(cc_array_partial_sort(a, N, sort_value_cmp));
+    for (size_t i = 0; i < N; i++)
+        ASSERT_EQ((int) i, *select_value_at(a, i));
+
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_top_k() {
+    enum { N = 3000, K = 100 };
+    static int v[N];
+
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+    for (size_t i = 0; i < N; i++) {
+        v[i] = (int) ((i * 7919) % N);
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+    }
+
+    CC_Array *top;
+    ASSERT_CC_OK(cc_array_new(&top));
+    int marker = -1;
+    ASSERT_CC_OK(cc_array_add(top, &marker));
+
+    /* The highest values, appended in descending order */
+    ASSERT_CC_OK(cc_array_top_k(a, K, sort_value_desc, top));
+    ASSERT_EQ(K + 1, cc_array_size(top));
+    ASSERT_EQ(-1, *select_value_at(top, 0));
+    for (size_t i = 0; i < K; i++)
+        ASSERT_EQ((int) (N - 1 - i), *select_value_at(top, i + 1));
+
+    /* The source is left as it was */
+    for (size_t i = 0; i < N; i++)
+        ASSERT_EQ(&v[i], select_value_at(a, i));
+
+    /* Fewer elements than k, with the source as the destination */
+    cc_array_remove_all(top);
+    ASSERT_CC_OK(cc_array_add(top, &v[5]));
+    ASSERT_CC_OK(cc_array_add(top, &v[1]));
+    ASSERT_CC_OK(cc_array_add(top, &v[2]));
+    ASSERT_CC_OK(cc_array_top_k(top, 10, sort_value_cmp, top));
+    ASSERT_EQ(6, cc_array_size(top));
+    ASSERT_EQ(&v[5], select_value_at(top, 3));
+    ASSERT_EQ(&v[2], select_value_at(top, 4));
+    ASSERT_EQ(&v[1], select_value_at(top, 5));
+
+    cc_array_destroy(top);
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_zip_iter_add_range_after_remove_last() {
+    CC_Array *a;
+    CC_Array *b;
+    ASSERT_CC_OK(cc_array_new(&a));
+    ASSERT_CC_OK(cc_array_new(&b));
+
+    int v[3];
+    ASSERT_CC_OK(cc_array_add(a, &v[0]));
+    ASSERT_CC_OK(cc_array_add(b, &v[0]));
+
+    void *src1[] = {&v[1], &v[2]};
+    void *src2[] = {&v[2], &v[1]};
+
+    CC_ArrayZipIter iter;
+    cc_array_zip_iter_init(&iter, a, b);
+    void *e1;
+    void *e2;
+    ASSERT_CC_OK(cc_array_zip_iter_next(&iter, &e1, &e2));
+    ASSERT_CC_OK(cc_array_zip_iter_remove(&iter, NULL, NULL));
+
+    /* The iterator now points past the end of both arrays */
+    ASSERT_EQ(CC_ERR_OUT_OF_RANGE, cc_array_zip_iter_add_range(&iter, src1, src2, 2));
+    ASSERT_EQ(0, cc_array_size(a));
+    ASSERT_EQ(0, cc_array_size(b));
+    ASSERT_EQ(CC_ITER_END, cc_array_zip_iter_next(&iter, &e1, &e2));
+
+    cc_array_destroy(a);
+    cc_array_destroy(b);
+    return true;
+}
+
+static bool index_matches_scan(CC_Array *a, int *v, size_t nv)
+{
+    for (size_t k = 0; k < nv; k++) {
+        size_t first = cc_array_size(a);
+        for (size_t i = 0; i < cc_array_size(a); i++) {
+            void *e;
+            cc_array_get_at(a, i, &e);
+            if (e == &v[k]) {
+                first = i;
+                break;
+            }
+        }
+        size_t idx;
+        if (cc_array_contains(a, &v[k]) != linear_count(a, &v[k]))
+            return false;
+        if (first == cc_array_size(a)) {
+            if (cc_array_index_of(a, &v[k], &idx) == CC_OK)
+                return false;
+        } else if (cc_array_index_of(a, &v[k], &idx) != CC_OK || idx != first) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool test_cc_array_index_in_place_updates() {
+    enum { NV = 12 };
+    static int v[NV];
+
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+    for (int i = 0; i < 40; i++)
+        ASSERT_CC_OK(cc_array_add(a, &v[i % NV]));
+    ASSERT_CC_OK(cc_array_index_enable(a));
+
+    unsigned seed = 11;
+    for (int step = 0; step < 2000; step++) {
+        seed = seed * 1103515245 + 12345;
+        size_t r    = seed >> 16;
+        size_t size = cc_array_size(a);
+        void *e     = &v[r % NV];
+
+        switch (step % 6) {
+        case 0:
+            ASSERT_CC_OK(cc_array_add_at(a, e, r % (size + 1)));
+            break;
+        case 1:
+            if (size)
+                ASSERT_CC_OK(cc_array_remove_at(a, r % size, NULL));
+            break;
+        case 2:
+            if (size)
+                ASSERT_CC_OK(cc_array_swap_at(a, r % size, (r >> 5) % size));
+            break;
+        case 3:
+            if (size)
+                ASSERT_CC_OK(cc_array_replace_at(a, e, r % size, NULL));
+            break;
+        case 4:
+            cc_array_remove(a, e, NULL);
+            break;
+        default: {
+            void *src[] = { e, &v[(r >> 4) % NV], e };
+            ASSERT_CC_OK(cc_array_add_range_at(a, src, 3, r % (size + 1)));
+            break;
+        }
+        }
+        ASSERT_TRUE(index_matches_scan(a, v, NV));
+    }
+
+    cc_array_destroy(a);
+    return true;
+}
+
+bool test_cc_array_mmap_threshold_arena() {
+    CC_Arena *arena;
+    ASSERT_CC_OK(cc_arena_new(1024, &arena));
+
+    CC_ArrayConf conf;
+    cc_array_conf_init(&conf);
+    conf.capacity       = 4;
+    conf.mmap_threshold = 4096;
+    conf.allocator      = cc_arena_allocator(arena);
+
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new_conf(&conf, &a));
+
+    /* The buffer stays in the arena, so resetting it releases everything */
+    size_t n = 10000;
+    for (size_t i = 0; i < n; i++)
+        ASSERT_CC_OK(cc_array_add(a, (void*) (i + 1)));
+    ASSERT_TRUE(cc_arena_used(arena) >= n * sizeof(void*));
+
+    cc_arena_reset(arena);
+    ASSERT_TRUE(cc_arena_used(arena) == 0);
+
+    cc_arena_destroy(arena);
+    return true;
+}
+
+/* Hands out blocks offset into a malloc allocation, which realloc and free
+ * would reject */
+static size_t offset_live_blocks;
+
+static void *offset_alloc(size_t size)
+{
+    char *p = malloc(size + 16);
+    if (!p)
+        return NULL;
+    offset_live_blocks++;
+    return p + 16;
+}
+
+static void *offset_calloc(size_t blocks, size_t size)
+{
+    char *p = offset_alloc(blocks * size);
+    if (p)
+        memset(p, 0, blocks * size);
+    return p;
+}
+
+static void offset_free(void *block)
+{
+    if (!block)
+        return;
+    offset_live_blocks--;
+    free((char*) block - 16);
+}
+
+bool test_cc_array_custom_allocator_without_realloc() {
+    CC_ArrayConf conf;
+    cc_array_conf_init(&conf);
+    conf.capacity   = 1;
+    conf.mem_alloc  = offset_alloc;
+    conf.mem_calloc = offset_calloc;
+    conf.mem_free   = offset_free;
+
+    offset_live_blocks = 0;
+
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new_conf(&conf, &a));
+    ASSERT_EQ(2, offset_live_blocks);
+
+    int v[100];
+    for (int i = 0; i < 100; i++)
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+
+    ASSERT_EQ(2, offset_live_blocks);
+    ASSERT_CC_OK(cc_array_trim_capacity(a));
+    ASSERT_EQ(100, cc_array_capacity(a));
+    ASSERT_EQ(2, offset_live_blocks);
+
+    void *e;
+    ASSERT_CC_OK(cc_array_get_at(a, 99, &e));
+    ASSERT_EQ(&v[99], e);
+
+    cc_array_destroy(a);
+    ASSERT_EQ(0, offset_live_blocks);
+    return true;
+}
+
+static int sorted_value_cmp_desc(const void *a, const void *b)
+{
+    return sorted_value_cmp(b, a);
+}
+
+bool test_cc_array_add_sorted_other_cmp() {
+    CC_Array *a;
+    ASSERT_CC_OK(cc_array_new(&a));
+
+    static int v[] = { 1, 2, 3, 4 };
+    for (int i = 0; i < 4; i++)
+        ASSERT_CC_OK(cc_array_add(a, &v[i]));
+    cc_array_set_sorted(a, sorted_value_cmp);
+
+    /* Inserting by another order breaks the marked one, so the mark goes */
+    static int zero = 0;
+    ASSERT_CC_OK(cc_array_add_sorted(a, &zero, sorted_value_cmp_desc));
+
+    void *e;
+    ASSERT_CC_OK(cc_array_get_at(a, 4, &e));
+    ASSERT_EQ(&zero, e);
+
+    int key = 0;
+    ASSERT_EQ(1, cc_array_contains_value(a, &key, sorted_value_cmp));
+
+    cc_array_destroy(a);
+    return true;
+}
+
 test_t TESTS[] = {
     &test_cc_array_new_conf_valid_conf,
     &test_cc_array_new_conf_exp_factor_default,
@@ -5626,5 +7651,53 @@ test_t TESTS[] = {
     &test_cc_array_zip_iter_replace_mutant_div,
     &test_cc_array_zip_iter_replace_mutant_mod,
     &test_cc_array_zip_iter_replace_mutant_no_subtract,
+    &test_cc_arrayv_add_get_by_value,
+    &test_cc_arrayv_add_at_remove_at,
+    &test_cc_arrayv_sort_filter_contains,
+    &test_cc_arrayv_iter_remove_add,
+    &test_cc_array_typed_add_get_remove,
+    &test_cc_array_typed_sort_iter,
+    &test_cc_array_arena_allocator,
+    &test_cc_arena_realloc_in_place,
+    &test_cc_array_expand_uses_realloc,
+    &test_cc_array_expand_without_realloc,
+    &test_cc_array_mmap_threshold,
+    &test_cc_array_inline_slots,
+    &test_cc_array_new_fixed,
+    &test_cc_array_auto_shrink,
+    &test_cc_array_growth_strategies,
+    &test_cc_array_reserve_add_all,
+    &test_cc_array_append_array,
+    &test_cc_array_add_range_at,
+    &test_cc_array_zip_iter_add_range,
+    &test_cc_array_remove_range,
+    &test_cc_array_remove_indices,
+    &test_cc_array_remove_indices_unsorted,
+    &test_cc_array_slice,
+    &test_cc_array_copy_cow,
+    &test_cc_array_copy_cow_destroy_original,
+    &test_cc_array_remove_unordered,
+    &test_cc_array_iter_remove_unordered,
+    &test_cc_array_filter_mut_alternating,
+    &test_cc_array_partition,
+    &test_cc_array_partition_stable,
+    &test_cc_array_filter_into,
+    &test_cc_array_index,
+    &test_cc_array_bsearch_bounds,
+    &test_cc_array_add_sorted,
+    &test_cc_array_sort_patterns,
+    &test_cc_sort_declare,
+    &test_cc_array_sort_stable,
+    &test_cc_array_sort_stable_scratch,
+    &test_cc_array_sort_parallel,
+    &test_cc_array_sort_by_key,
+    &test_cc_array_select_nth,
+    &test_cc_array_partial_sort,
+    &test_cc_array_top_k,
+    &test_cc_array_zip_iter_add_range_after_remove_last,
+    &test_cc_array_index_in_place_updates,
+    &test_cc_array_mmap_threshold_arena,
+    &test_cc_array_custom_allocator_without_realloc,
+    &test_cc_array_add_sorted_other_cmp,
     NULL
 };
\ No newline at end of file